@@ -25,7 +25,5 @@ win32 {
 
 # QMAKE_CXXFLAGS_RELEASE += -ffast-math
 
-SOURCES += main.cpp\
-    mandelbrotview.cpp
-
-HEADERS  += mandelbrotview.h
+CONFIG += tbb
+include(../c++/cppmandel.pri)
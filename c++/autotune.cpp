@@ -0,0 +1,142 @@
+#include "autotune.h"
+#include <QSettings>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QDir>
+#include <vector>
+
+const static int timing_runs = 2;
+
+static QString profile_path()
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
+    QDir().mkpath(dir);
+    return QDir(dir).filePath("autotune.ini");
+}
+
+// Profiles are kept per host so that a home directory shared across a
+// cluster still gives every node its own choice.
+static QString profile_group(const Formula& formula, const QString& backend)
+{
+    QString group = QSysInfo::machineHostName() + "/" + formula.name;
+    if(!backend.isEmpty())
+        group += "/" + backend;
+    return group;
+}
+
+static bool load_profile(const QString& group, Profile& profile)
+{
+    QSettings settings(profile_path(), QSettings::IniFormat);
+    settings.beginGroup(group);
+    if(!settings.contains("backend") || settings.value("cores").toInt() != QThread::idealThreadCount())
+        return false;
+    profile.backend = settings.value("backend").toString();
+    profile.config.threads = settings.value("threads").toInt();
+    profile.config.tile_rows = settings.value("tile_rows").toInt();
+    profile.config.local_size = settings.value("local_size").toInt();
+    profile.config.tile_cols = settings.value("tile_cols").toInt();
+    profile.milliseconds = settings.value("milliseconds").toDouble();
+    return true;
+}
+
+static void save_profile(const QString& group, const Profile& profile)
+{
+    QSettings settings(profile_path(), QSettings::IniFormat);
+    settings.beginGroup(group);
+    settings.setValue("backend", profile.backend);
+    settings.setValue("threads", profile.config.threads);
+    settings.setValue("tile_rows", profile.config.tile_rows);
+    settings.setValue("local_size", profile.config.local_size);
+    settings.setValue("tile_cols", profile.config.tile_cols);
+    settings.setValue("milliseconds", profile.milliseconds);
+    settings.setValue("cores", QThread::idealThreadCount());
+}
+
+Profile autotune(const Formula& formula, const QString& backend, bool retune)
+{
+    const QString group = profile_group(formula, backend);
+    Profile best = { "qtconcurrent", { parallelism, N / parallelism, 0, 0 }, 0.0 };
+    if(!retune && load_profile(group, best))
+        return best;
+
+    const Viewport vp = formula.view(N, N);
+    std::vector<SmoothCount> reference(N * N);
+    std::vector<SmoothCount> out(N * N);
+    bool have_reference = false;
+    best.milliseconds = -1.0;
+
+    const QStringList names = backend.isEmpty() ? renderer_names() : QStringList(backend);
+    for(int b = 0; b < names.size(); ++b)
+    {
+        Renderer* renderer = create_renderer(names[b]);
+        if(!renderer)
+        {
+            if(!backend.isEmpty())
+                qWarning("autotune: backend %s is not available", qPrintable(backend));
+            continue;
+        }
+        if(!renderer->supports(formula))
+        {
+            if(!backend.isEmpty())
+                qWarning("autotune: backend %s does not support %s", qPrintable(backend), formula.name);
+            delete renderer;
+            continue;
+        }
+
+        const QVector<RenderConfig> configs = renderer->candidates();
+        for(int c = 0; c < configs.size(); ++c)
+        {
+            double fastest = -1.0;
+            for(int run = 0; run < timing_runs; ++run)
+            {
+                QElapsedTimer timer;
+                timer.start();
+                renderer->render(formula, vp, &out[0], configs[c]);
+                const double ms = timer.nsecsElapsed() / 1e6;
+                if(fastest < 0 || ms < fastest)
+                    fastest = ms;
+            }
+
+            // A backend that renders a different picture is broken, however fast.
+            if(!have_reference)
+            {
+                reference.swap(out);
+                have_reference = true;
+            }
+            else
+            {
+                double error = 0.0;
+                for(int i = 0; i < N * N; ++i)
+                    error = std::max(error, fabs(smooth_log(out[i], formula.offset) - smooth_log(reference[i], formula.offset)));
+                if(error > 1e-3)
+                {
+                    qWarning("autotune: %s differs from the reference by %g, skipped", renderer->name(), error);
+                    break;
+                }
+            }
+
+            qDebug("autotune: %s threads %d tile_rows %d tile_cols %d local_size %d: %.2f milliseconds",
+                   renderer->name(), configs[c].threads, configs[c].tile_rows, configs[c].tile_cols,
+                   configs[c].local_size, fastest);
+            if(best.milliseconds < 0 || fastest < best.milliseconds)
+            {
+                best.backend = names[b];
+                best.config = configs[c];
+                best.milliseconds = fastest;
+            }
+        }
+        delete renderer;
+    }
+
+    // Only fall back to the always built backend when none was asked for.
+    if(best.milliseconds < 0)
+    {
+        best.backend = backend.isEmpty() ? "qtconcurrent" : "";
+        best.milliseconds = 0.0;
+    }
+    else
+        save_profile(group, best);
+    return best;
+}
@@ -0,0 +1,22 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include "renderer.h"
+
+// The fastest backend and configuration found on this machine.
+struct Profile
+{
+    QString backend;
+    RenderConfig config;
+    double milliseconds;
+};
+
+// Returns the profile saved for this host and formula. If there is none
+// yet, or retune is set, every compiled-in backend (only backend, if not
+// empty) is timed with each of its candidate configurations on the
+// formula's default view. The winner is saved for later runs. If backend
+// is given but is not compiled in or cannot render formula, the returned
+// profile has an empty backend.
+Profile autotune(const Formula& formula, const QString& backend, bool retune);
+
+#endif // AUTOTUNE_H
@@ -0,0 +1,182 @@
+#include "renderer.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string.h>
+#include <CL/cl.hpp>
+
+const static unsigned oclplatform = 1;
+
+// ********************************************************************
+// OpenCL backend
+//
+// Runs mandel.cl (read from the working directory) over the rows with a
+// work-group size of local_size, 0 leaving it to the driver.
+class CLMandel : public Renderer
+{
+    cl::Context m_context;
+    cl::Device  m_device;
+    cl::CommandQueue m_cmdq;
+    cl::Kernel m_kernel;
+    size_t m_max_local;
+
+    bool checkErr(cl_int err, const char * name)
+    {
+        if (err != CL_SUCCESS) {
+            std::cerr << "ERROR: " << name << " (" << err << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+public:
+    bool ok;
+
+    CLMandel() : m_max_local(0), ok(false)
+    {
+        cl_int err;
+        std::vector< cl::Platform > platformList;
+        cl::Platform::get(&platformList);
+        if(!checkErr(platformList.size()!=0 ? CL_SUCCESS : -1, "cl::Platform::get"))
+            return;
+        std::cerr << "Platform number is: " << platformList.size() << std::endl;
+
+        std::string platformVendor;
+        for(unsigned i = 0; i < platformList.size(); ++i)
+        {
+            platformList[i].getInfo((cl_platform_info)CL_PLATFORM_VENDOR, &platformVendor);
+            std::cerr << "Platform is by: " << platformVendor << "\n";
+        }
+
+        const unsigned platform = oclplatform < platformList.size() ? oclplatform : 0;
+        cl_context_properties cprops[3] =
+            {CL_CONTEXT_PLATFORM, (cl_context_properties)(platformList[platform])(), 0};
+
+        m_context = cl::Context (
+           CL_DEVICE_TYPE_ALL,
+           cprops,
+           NULL,
+           NULL,
+           &err);
+        if(!checkErr(err, "Conext::Context()"))
+            return;
+
+        std::vector<cl::Device> devices;
+        devices = m_context.getInfo<CL_CONTEXT_DEVICES>();
+        if(!checkErr(devices.size() > 0 ? CL_SUCCESS : -1, "devices.size() > 0"))
+            return;
+
+        for(unsigned i = 0; i < devices.size(); ++i)
+        {
+            cl_int deviceType = devices[i].getInfo<CL_DEVICE_TYPE>();
+            std::cerr << "Device " << i << ": ";
+            if(deviceType & CL_DEVICE_TYPE_CPU)
+                std::cerr << "CL_DEVICE_TYPE_CPU ";
+            if(deviceType & CL_DEVICE_TYPE_GPU)
+                std::cerr << "CL_DEVICE_TYPE_GPU ";
+            if(deviceType & CL_DEVICE_TYPE_ACCELERATOR)
+                std::cerr << "CL_DEVICE_TYPE_ACCELERATOR ";
+            if(deviceType & CL_DEVICE_TYPE_DEFAULT)
+                std::cerr << "CL_DEVICE_TYPE_DEFAULT ";
+            std::cerr << std::endl;
+        }
+
+        m_device = devices[0];
+        m_max_local = m_device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+
+        m_cmdq = cl::CommandQueue(m_context, m_device, 0, &err);
+        if(!checkErr(err, "CommandQueue::CommandQueue()"))
+            return;
+
+        std::ifstream file("mandel.cl");
+        std::string prog((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        cl::Program::Sources source(1, std::make_pair(prog.c_str(), prog.length()+1));
+        cl::Program program(m_context, source);
+        err = program.build(devices,"");
+        if(!checkErr(err, "Program::build()"))
+            return;
+
+        m_kernel = cl::Kernel(program, "mandel", &err);
+        ok = checkErr(err, "Kernel::Kernel()");
+    }
+
+    const char* name() const { return "opencl"; }
+
+    // mandel.cl only implements the Mandelbrot iteration.
+    bool supports(const Formula& formula) const { return strcmp(formula.name, "mandelbrot") == 0; }
+
+    QVector<RenderConfig> candidates() const
+    {
+        QVector<RenderConfig> configs;
+        const int locals[] = { 0, 32, 64, 128, 256, 512, 1024 };
+        for(int i = 0; i < 7; ++i)
+            if((size_t)locals[i] <= m_max_local)
+            {
+                const RenderConfig config = { 0, 0, locals[i], 0 };
+                configs.append(config);
+            }
+        return configs;
+    }
+
+    void render_rows(const Formula&, const Viewport& vp, SmoothCount* out,
+                     int beg, int end, const RenderConfig& config)
+    {
+        if(end <= beg)
+            return;
+        cl_int err;
+        const int size = vp.width * (end - beg);
+        SmoothCount* buf = out + (size_t)beg * vp.width;
+        cl::Buffer outbuf(
+            m_context,
+            CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR,
+            size*sizeof(SmoothCount),
+            buf,
+            &err);
+        checkErr(err, "Buffer::Buffer()");
+
+        int arg = 0;
+        m_kernel.setArg(arg++, outbuf);
+        m_kernel.setArg(arg++, vp.x0);
+        m_kernel.setArg(arg++, vp.y0 + beg * vp.step);
+        m_kernel.setArg(arg++, vp.step);
+        m_kernel.setArg(arg++, size);
+        m_kernel.setArg(arg++, vp.width);
+        m_kernel.setArg(arg++, depth);
+        err = m_kernel.setArg(arg++, escape2);
+        checkErr(err, "Kernel::setArg()");
+
+        // The global size has to be a multiple of the work-group size, the
+        // kernel ignores the extra items.
+        const int local = config.local_size;
+        const int global = local ? (size + local - 1) / local * local : size;
+        cl::Event event;
+        err = m_cmdq.enqueueNDRangeKernel(
+            m_kernel,
+            cl::NullRange,
+            cl::NDRange(global),
+            local ? cl::NDRange(local) : cl::NullRange,
+            NULL,
+            &event);
+        checkErr(err, "ComamndQueue::enqueueNDRangeKernel()");
+
+        event.wait();
+        err = m_cmdq.enqueueReadBuffer(
+            outbuf,
+            CL_TRUE,
+            0,
+            size*sizeof(SmoothCount),
+            buf);
+        checkErr(err, "ComamndQueue::enqueueReadBuffer()");
+    }
+};
+
+Renderer* create_opencl_renderer()
+{
+    CLMandel* renderer = new CLMandel;
+    if(!renderer->ok)
+    {
+        delete renderer;
+        return 0;
+    }
+    return renderer;
+}
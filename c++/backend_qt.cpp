@@ -0,0 +1,53 @@
+#include "renderer.h"
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <QThread>
+
+// ********************************************************************
+// QtConcurrent backend
+//
+// Rows are handed out tile_rows at a time to a private pool of threads
+// worker threads.
+class QtConcurrentRenderer : public Renderer
+{
+    QThreadPool m_pool;
+public:
+    const char* name() const { return "qtconcurrent"; }
+
+    QVector<RenderConfig> candidates() const
+    {
+        const int cores = QThread::idealThreadCount();
+        const int threads[] = { cores, 2 * cores, parallelism };
+        const int tiles[] = { 1, 4, 16, 64 };
+        QVector<RenderConfig> configs;
+        for(int t = 0; t < 3; ++t)
+            for(int r = 0; r < 4; ++r)
+            {
+                const RenderConfig config = { threads[t], tiles[r], 0, 0 };
+                configs.append(config);
+            }
+        return configs;
+    }
+
+    void render_rows(const Formula& formula, const Viewport& vp, SmoothCount* out,
+                     int beg, int end, const RenderConfig& config)
+    {
+        m_pool.setMaxThreadCount(config.threads);
+        const int tile = std::max(config.tile_rows, 1);
+        QVector<QFuture<void> > results;
+        for(int y = beg; y < end; y += tile)
+        {
+            const int y1 = std::min(y + tile, end);
+            results.append(QtConcurrent::run(&m_pool, [=, &formula]() {
+                render_band(formula, vp, out, y, y1, 0, vp.width);
+            }));
+        }
+        for(int i = 0; i < results.size(); ++i)
+            results[i].waitForFinished();
+    }
+};
+
+Renderer* create_qtconcurrent_renderer()
+{
+    return new QtConcurrentRenderer;
+}
@@ -0,0 +1,74 @@
+#include "renderer.h"
+#include <QThread>
+#include <tbb/task_arena.h>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range2d.h>
+#include <tbb/partitioner.h>
+#include <memory>
+
+// ********************************************************************
+// TBB backend
+//
+// parallel_for over a blocked_range2d of rows x columns inside an arena of
+// threads threads. The grain is tile_rows by tile_cols (0 meaning whole
+// rows), and every leaf range is rendered row by row, so a task costs one
+// call into the kernel rather than one per pixel.
+//
+// The affinity_partitioner lives as long as the arena: successive frames
+// cover the same range, so it replays the previous frame's task-to-thread
+// mapping and a tile tends to land on the core that rendered it last.
+class TbbRenderer : public Renderer
+{
+    tbb::task_arena m_arena;
+    std::unique_ptr<tbb::affinity_partitioner> m_affinity;
+    int m_threads;
+public:
+    TbbRenderer() : m_threads(0) {}
+
+    const char* name() const { return "tbb"; }
+
+    QVector<RenderConfig> candidates() const
+    {
+        const int cores = QThread::idealThreadCount();
+        const int threads[] = { cores, 2 * cores };
+        const int tiles[] = { 1, 4, 16 };
+        const int cols[] = { 64, 256, 0 };
+        QVector<RenderConfig> configs;
+        for(int t = 0; t < 2; ++t)
+            for(int r = 0; r < 3; ++r)
+                for(int c = 0; c < 3; ++c)
+                {
+                    const RenderConfig config = { threads[t], tiles[r], 0, cols[c] };
+                    configs.append(config);
+                }
+        return configs;
+    }
+
+    void render_rows(const Formula& formula, const Viewport& vp, SmoothCount* out,
+                     int beg, int end, const RenderConfig& config)
+    {
+        if(config.threads != m_threads)
+        {
+            if(m_threads)
+                m_arena.terminate();
+            m_arena.initialize(config.threads);
+            m_affinity.reset(new tbb::affinity_partitioner);
+            m_threads = config.threads;
+        }
+        if(end <= beg)
+            return;
+        const int cols = config.tile_cols > 0 ? config.tile_cols : vp.width;
+        const tbb::blocked_range2d<int> tiles(beg, end, std::max(config.tile_rows, 1), 0, vp.width, cols);
+        tbb::affinity_partitioner& affinity = *m_affinity;
+        m_arena.execute([&]() {
+            tbb::parallel_for(tiles, [&](const tbb::blocked_range2d<int>& r) {
+                render_band(formula, vp, out, r.rows().begin(), r.rows().end(), r.cols().begin(), r.cols().end());
+            }, affinity);
+        });
+    }
+};
+
+Renderer* create_tbb_renderer()
+{
+    return new TbbRenderer;
+}
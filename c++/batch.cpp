@@ -0,0 +1,125 @@
+#include "batch.h"
+#include "renderer.h"
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+const static int tile_pixels = 16384;   // target size of one queued tile
+
+struct BatchTile
+{
+    int job;
+    int beg;
+    int end;
+    qint64 start;
+    qint64 finish;
+};
+
+BatchRenderer::BatchRenderer(int threads)
+{
+    m_pool.setMaxThreadCount(std::max(threads, 1));
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    for(size_t i = 0; i < m_free.size(); ++i)
+        delete m_free[i];
+}
+
+// The smallest free buffer that is large enough, a new one otherwise.
+std::vector<SmoothCount>* BatchRenderer::acquire(size_t size)
+{
+    QMutexLocker lock(&m_mutex);
+    int best = -1;
+    for(int i = 0; i < (int)m_free.size(); ++i)
+        if(m_free[i]->capacity() >= size && (best < 0 || m_free[i]->capacity() < m_free[best]->capacity()))
+            best = i;
+    std::vector<SmoothCount>* buffer = new std::vector<SmoothCount>;
+    if(best >= 0)
+    {
+        delete buffer;
+        buffer = m_free[best];
+        m_free.erase(m_free.begin() + best);
+    }
+    buffer->resize(size);
+    return buffer;
+}
+
+void BatchRenderer::release(const BatchResult& result)
+{
+    QMutexLocker lock(&m_mutex);
+    m_free.push_back(result.buffer);
+}
+
+QVector<BatchResult> BatchRenderer::render(const QVector<BatchJob>& jobs)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    // Buffers and tiles are set up here, so the workers share nothing but
+    // the queue position and the per-job tile counts.
+    QVector<BatchResult> results(jobs.size());
+    std::vector<MirrorPlan> plans(jobs.size());
+    std::vector<BatchTile> tiles;
+    for(int j = 0; j < jobs.size(); ++j)
+    {
+        const Viewport& vp = jobs[j].vp;
+        const BatchResult result = { acquire((size_t)vp.width * vp.height), 0, 0, 0, 0 };
+        results[j] = result;
+        const MirrorPlan full = { 0, vp.height, 0 };
+        plans[j] = jobs[j].formula->conjugate_symmetric ? plan_mirror(vp) : full;
+
+        const int rows = std::max(tile_pixels / std::max(vp.width, 1), 1);
+        for(int y = plans[j].first; y < plans[j].last; y += rows)
+        {
+            const BatchTile tile = { j, y, std::min(y + rows, plans[j].last), 0, 0 };
+            tiles.push_back(tile);
+            ++results[j].tiles;
+        }
+    }
+
+    std::vector<SmoothCount*> outs(jobs.size());
+    std::vector<QAtomicInt> remaining(jobs.size());
+    for(int j = 0; j < jobs.size(); ++j)
+    {
+        outs[j] = results[j].buffer->empty() ? 0 : &(*results[j].buffer)[0];
+        remaining[j].store(results[j].tiles);
+    }
+    QAtomicInt next(0);
+    BatchTile* tile_data = tiles.empty() ? 0 : &tiles[0];
+    const int tile_count = (int)tiles.size();
+
+    // The last tile of a job to finish mirrors its rows.
+    auto drain = [&]() {
+        for(int t; (t = next.fetchAndAddRelaxed(1)) < tile_count; )
+        {
+            BatchTile& tile = tile_data[t];
+            const BatchJob& job = jobs[tile.job];
+            SmoothCount* out = outs[tile.job];
+            tile.start = clock.nsecsElapsed();
+            render_band(*job.formula, job.vp, out, tile.beg, tile.end, 0, job.vp.width);
+            if(remaining[tile.job].fetchAndAddOrdered(-1) == 1)
+                mirror_rows(plans[tile.job], job.vp.width, job.vp.height, out);
+            tile.finish = clock.nsecsElapsed();
+        }
+    };
+
+    const int workers = std::min(m_pool.maxThreadCount(), tile_count) - 1;
+    QVector<QFuture<void> > futures;
+    for(int i = 0; i < workers; ++i)
+        futures.append(QtConcurrent::run(&m_pool, drain));
+    drain();
+    for(int i = 0; i < futures.size(); ++i)
+        futures[i].waitForFinished();
+
+    // A job's tiles are adjacent in the queue.
+    for(int t = 0; t < tile_count; ++t)
+    {
+        BatchResult& result = results[tiles[t].job];
+        if(t == 0 || tiles[t - 1].job != tiles[t].job || tiles[t].start < result.start)
+            result.start = tiles[t].start;
+        result.finish = std::max(result.finish, tiles[t].finish);
+        result.busy += tiles[t].finish - tiles[t].start;
+    }
+    return results;
+}
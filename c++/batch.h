@@ -0,0 +1,51 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <QThreadPool>
+#include <QMutex>
+#include <QVector>
+#include <vector>
+#include "formula.h"
+
+// One image of a batch.
+struct BatchJob
+{
+    const Formula* formula;
+    Viewport vp;
+};
+
+// What render() made of a BatchJob. Times are nanoseconds since the batch
+// started, busy is the sum of the job's tile times.
+struct BatchResult
+{
+    std::vector<SmoothCount>* buffer;   // vp.width x vp.height, from the pool
+    qint64 start;
+    qint64 finish;
+    qint64 busy;
+    int tiles;
+};
+
+// Renders many viewports as one piece of work. Every job is cut into
+// tiles of about the same pixel count and all tiles go into one queue
+// that the threads of a single pool drain, so small images do not leave
+// cores idle at the end of each one. Buffers come from a pool and go
+// back to it with release(), so a gallery rendered batch after batch
+// does not allocate per image.
+class BatchRenderer
+{
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    std::vector<std::vector<SmoothCount>*> m_free;
+
+    std::vector<SmoothCount>* acquire(size_t size);
+public:
+    BatchRenderer(int threads);
+    ~BatchRenderer();
+
+    QVector<BatchResult> render(const QVector<BatchJob>& jobs);
+
+    // Returns a result's buffer to the pool, safe to call from any thread.
+    void release(const BatchResult& result);
+};
+
+#endif // BATCH_H
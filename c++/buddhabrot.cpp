@@ -0,0 +1,201 @@
+#include "buddhabrot.h"
+#include "mandel.h"
+#include <QtGui>
+#include <QtConcurrent>
+#include <vector>
+#include <random>
+
+const static int map_size = 256;    // pre-pass grid
+
+// ********************************************************************
+// Importance map
+//
+// The pre-pass renders the escape-time image of the sampling region.
+// Cells are picked with probability proportional to their iteration count,
+// so short orbits far outside are rare, and interior cells next to
+// escaping ones get the full weight because they hold the long orbits.
+// Every cell keeps a non-zero weight, and samples carry
+// uniform / actual probability, so the density stays unbiased.
+class ImportanceMap
+{
+    Viewport m_vp;
+    std::vector<double> m_cdf;
+public:
+    ImportanceMap(const Viewport& vp) : m_vp(vp), m_cdf(vp.width * vp.height)
+    {
+        std::vector<SmoothCount> counts(vp.width * vp.height);
+        render<Mandelbrot>(vp, &counts[0]);
+
+        double total = 0.0;
+        for(int y = 0; y < vp.height; ++y)
+            for(int x = 0; x < vp.width; ++x)
+            {
+                const int i = y * vp.width + x;
+                double weight = counts[i].count;
+                if(counts[i].count == depth)
+                {
+                    bool boundary = false;
+                    for(int dy = -1; dy <= 1; ++dy)
+                        for(int dx = -1; dx <= 1; ++dx)
+                        {
+                            const int nx = x + dx, ny = y + dy;
+                            if(nx >= 0 && ny >= 0 && nx < vp.width && ny < vp.height &&
+                               counts[ny * vp.width + nx].count < depth)
+                                boundary = true;
+                        }
+                    weight = boundary ? depth : 1.0;
+                }
+                total += weight;
+                m_cdf[i] = total;
+            }
+    }
+
+    // Returns a point c and its importance weight.
+    template<class Rng>
+    std::complex<double> sample(Rng& rng, double& weight) const
+    {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        const double total = m_cdf.back();
+        const size_t cell = std::min<size_t>(
+            std::upper_bound(m_cdf.begin(), m_cdf.end(), uniform(rng) * total) - m_cdf.begin(),
+            m_cdf.size() - 1);
+        const double p = m_cdf[cell] - (cell ? m_cdf[cell - 1] : 0.0);
+        weight = total / (p * m_cdf.size());
+        return std::complex<double>(m_vp.x0 + (cell % m_vp.width + uniform(rng)) * m_vp.step,
+                                    m_vp.y0 + (cell / m_vp.width + uniform(rng)) * m_vp.step);
+    }
+};
+
+// ********************************************************************
+// Orbits
+inline bool in_main_bulbs(const std::complex<double>& c)
+{
+    const double x = c.real() - 0.25, y2 = c.imag() * c.imag();
+    const double q = x * x + y2;
+    const double x1 = c.real() + 1.0;
+    return q * (q + x) <= 0.25 * y2 || x1 * x1 + y2 <= 1.0 / 16.0;
+}
+
+// Density of one job, channels x height x width.
+struct Density
+{
+    int channels;
+    std::vector<double> data;
+};
+
+static void accumulate(const BuddhaSpec& spec, const Viewport& vp, const ImportanceMap& map,
+                       int channels, long long samples, unsigned seed, Density* density)
+{
+    density->channels = channels;
+    density->data.assign((size_t)channels * vp.width * vp.height, 0.0);
+    double* out = &density->data[0];
+    const size_t plane = (size_t)vp.width * vp.height;
+    const int limit = *std::max_element(spec.limits, spec.limits + channels);
+
+    std::mt19937_64 rng(seed);
+    for(long long s = 0; s < samples; ++s)
+    {
+        double weight;
+        const std::complex<double> c = map.sample(rng, weight);
+        if(in_main_bulbs(c))
+            continue;
+        double magz2;
+        const int k = iterate<Mandelbrot>(c, limit, magz2);
+        if(k == limit)
+            continue;
+
+        // The orbit of conj(c) is the conjugate orbit, so every sample
+        // also counts for its mirror image at half weight each.
+        const double w = 0.5 * weight;
+        std::complex<double> z(0, 0);
+        for(int i = 0; i < k; ++i)
+        {
+            z = z * z + c;
+            const int x = (int)floor((z.real() - vp.x0) / vp.step);
+            const int y0 = (int)floor((z.imag() - vp.y0) / vp.step);
+            const int y1 = (int)floor((-z.imag() - vp.y0) / vp.step);
+            if(x < 0 || x >= vp.width)
+                continue;
+            for(int ch = 0; ch < channels; ++ch)
+            {
+                if(k >= spec.limits[ch])
+                    continue;
+                double* p = out + ch * plane;
+                if(y0 >= 0 && y0 < vp.height)
+                    p[(size_t)y0 * vp.width + x] += w;
+                if(y1 >= 0 && y1 < vp.height)
+                    p[(size_t)y1 * vp.width + x] += w;
+            }
+        }
+    }
+}
+
+// ********************************************************************
+// Output
+bool render_buddhabrot(const BuddhaSpec& spec, const QString& path)
+{
+    if(spec.width < 1 || spec.height < 1 || spec.samples < 1)
+        return false;
+
+    const double size = 3.0;
+    const double step = size / std::max(spec.width, spec.height);
+    const Viewport vp = { -2.0, -0.5 * spec.height * step, step, spec.width, spec.height };
+    const Viewport region = { -2.0, -1.5, size / map_size, map_size, map_size };
+    const bool grey = spec.limits[0] == spec.limits[1] && spec.limits[1] == spec.limits[2];
+    const int channels = grey ? 1 : 3;
+
+    QElapsedTimer time;
+    time.start();
+    const ImportanceMap map(region);
+
+    // One job per core and no shared counters: each job fills its own Density.
+    const int jobs = std::max(QThread::idealThreadCount(), 1);
+    std::vector<Density> densities(jobs);
+    {
+        QVector<QFuture<void> > results(jobs);
+        const long long job = spec.samples / jobs;
+        for(int i = 0; i < jobs; ++i)
+        {
+            const long long samples = i < jobs - 1 ? job : spec.samples - job * (jobs - 1);
+            Density* density = &densities[i];
+            results[i] = QtConcurrent::run([&spec, &vp, &map, channels, samples, i, density]() {
+                accumulate(spec, vp, map, channels, samples, 12345u + i, density);
+            });
+        }
+        for(int i = 0; i < jobs; ++i)
+            results[i].waitForFinished();
+    }
+
+    std::vector<double>& total = densities[0].data;
+    for(int i = 1; i < jobs; ++i)
+    {
+        const std::vector<double>& d = densities[i].data;
+        for(size_t j = 0; j < total.size(); ++j)
+            total[j] += d[j];
+        std::vector<double>().swap(densities[i].data);
+    }
+    qDebug("%lld samples in %lld milliseconds", spec.samples, (long long)time.elapsed());
+
+    // Square-root tone mapping, each channel scaled to its own maximum.
+    const size_t plane = (size_t)vp.width * vp.height;
+    double peak[3] = { 0.0, 0.0, 0.0 };
+    for(int ch = 0; ch < channels; ++ch)
+        peak[ch] = std::max(*std::max_element(total.begin() + ch * plane, total.begin() + (ch + 1) * plane), 1e-30);
+
+    QImage image(vp.width, vp.height, QImage::Format_RGB32);
+    for(int y = 0; y < vp.height; ++y)
+    {
+        uint32_t* line = (uint32_t*)image.scanLine(y);
+        for(int x = 0; x < vp.width; ++x)
+        {
+            int rgb[3];
+            for(int ch = 0; ch < 3; ++ch)
+            {
+                const int c = grey ? 0 : ch;
+                rgb[ch] = (int)(255.0 * sqrt(total[c * plane + (size_t)y * vp.width + x] / peak[c]));
+            }
+            line[x] = rgb[2] | (rgb[1] << 8) | (rgb[0] << 16) | 0xff000000;
+        }
+    }
+    return image.save(path);
+}
@@ -0,0 +1,22 @@
+#ifndef BUDDHABROT_H
+#define BUDDHABROT_H
+
+#include <QString>
+
+// Orbit density of escaping points. With three different iteration
+// limits the channels form a Nebulabrot, with equal limits it is the grey
+// Buddhabrot.
+struct BuddhaSpec
+{
+    int width;
+    int height;
+    long long samples;
+    int limits[3];      // red, green, blue
+};
+
+// Samples spec.samples points c, weighted towards the boundary by an
+// escape-time pre-pass, and accumulates the orbits of those that escape.
+// Every job has its own density buffers, summed once at the end.
+bool render_buddhabrot(const BuddhaSpec& spec, const QString& path);
+
+#endif // BUDDHABROT_H
@@ -0,0 +1,63 @@
+# Sources shared by every frontend. The QtConcurrent backend is always
+# built, add CONFIG += tbb or CONFIG += opencl for the other backends and
+# CONFIG += fastlog for the polynomial logarithms.
+
+QT       += core gui widgets concurrent network
+
+CONFIG += c++11
+
+INCLUDEPATH += $$PWD
+
+SOURCES += $$PWD/main.cpp\
+    $$PWD/mandelbrotview.cpp\
+    $$PWD/zoomanimation.cpp\
+    $$PWD/tileserver.cpp\
+    $$PWD/renderstats.cpp\
+    $$PWD/formula.cpp\
+    $$PWD/renderer.cpp\
+    $$PWD/backend_qt.cpp\
+    $$PWD/autotune.cpp\
+    $$PWD/recolor.cpp\
+    $$PWD/buddhabrot.cpp\
+    $$PWD/distributed.cpp\
+    $$PWD/deepzoom.cpp\
+    $$PWD/batch.cpp
+
+HEADERS  += $$PWD/mandelbrotview.h\
+    $$PWD/mandel.h\
+    $$PWD/zoomanimation.h\
+    $$PWD/tileserver.h\
+    $$PWD/renderstats.h\
+    $$PWD/formula.h\
+    $$PWD/renderer.h\
+    $$PWD/autotune.h\
+    $$PWD/recolor.h\
+    $$PWD/buddhabrot.h\
+    $$PWD/distributed.h\
+    $$PWD/deepzoom.h\
+    $$PWD/batch.h\
+    $$PWD/parallel.h
+
+tbb {
+    DEFINES += HAVE_TBB
+    SOURCES += $$PWD/backend_tbb.cpp
+    LIBS += -ltbb
+}
+
+# Polynomial logarithms for the smooth colouring, see fast_log2() in mandel.h.
+# make check builds tests/fastlog.pro in fastlog_test/ and runs it, which
+# compares them against libm.
+fastlog {
+    DEFINES += FAST_LOG
+    QMAKE_CXXFLAGS += -ftree-vectorize
+}
+
+opencl {
+    DEFINES += HAVE_OPENCL
+    SOURCES += $$PWD/backend_opencl.cpp
+}
+
+# Accuracy test of fast_log2(), see above.
+fastlog_check.target = check
+fastlog_check.commands = $(MKDIR) fastlog_test && cd fastlog_test && $(QMAKE) $$PWD/tests/fastlog.pro && $(MAKE) check
+QMAKE_EXTRA_TARGETS += fastlog_check
@@ -13,7 +13,4 @@ TEMPLATE = app
 
 # QMAKE_CXXFLAGS_RELEASE += -ffast-math
 
-SOURCES += main.cpp\
-    mandelbrotview.cpp
-
-HEADERS  += mandelbrotview.h
+include(cppmandel.pri)
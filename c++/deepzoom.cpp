@@ -0,0 +1,313 @@
+#include "deepzoom.h"
+#include "parallel.h"
+#include <QtGui>
+#include <vector>
+
+// ********************************************************************
+// Double-double arithmetic
+//
+// hi + lo with |lo| <= ulp(hi) / 2, about 32 significant digits. Only
+// what the reference orbit needs.
+struct DoubleDouble
+{
+    double hi;
+    double lo;
+};
+
+inline DoubleDouble quick_two_sum(double a, double b)
+{
+    const double s = a + b;
+    const DoubleDouble r = { s, b - (s - a) };
+    return r;
+}
+
+inline DoubleDouble two_sum(double a, double b)
+{
+    const double s = a + b;
+    const double v = s - a;
+    const DoubleDouble r = { s, (a - (s - v)) + (b - v) };
+    return r;
+}
+
+inline DoubleDouble operator+(const DoubleDouble& a, const DoubleDouble& b)
+{
+    DoubleDouble s = two_sum(a.hi, b.hi);
+    const DoubleDouble t = two_sum(a.lo, b.lo);
+    s = quick_two_sum(s.hi, s.lo + t.hi);
+    return quick_two_sum(s.hi, s.lo + t.lo);
+}
+
+inline DoubleDouble operator-(const DoubleDouble& a)
+{
+    const DoubleDouble r = { -a.hi, -a.lo };
+    return r;
+}
+
+inline DoubleDouble operator-(const DoubleDouble& a, const DoubleDouble& b)
+{
+    return a + -b;
+}
+
+inline DoubleDouble operator*(const DoubleDouble& a, const DoubleDouble& b)
+{
+    const double p = a.hi * b.hi;
+    return quick_two_sum(p, std::fma(a.hi, b.hi, -p) + (a.hi * b.lo + a.lo * b.hi));
+}
+
+inline DoubleDouble operator/(const DoubleDouble& a, const DoubleDouble& b)
+{
+    const double q1 = a.hi / b.hi;
+    const DoubleDouble b1 = { q1, 0.0 };
+    const DoubleDouble r1 = a - b * b1;
+    const double q2 = r1.hi / b.hi;
+    const DoubleDouble b2 = { q2, 0.0 };
+    const DoubleDouble r2 = r1 - b * b2;
+    const DoubleDouble q3 = { r2.hi / b.hi, 0.0 };
+    return quick_two_sum(q1, q2) + q3;
+}
+
+// Parses [-]digits[.digits][e[-]digits] without going through a double.
+static bool parse_double_double(const QString& text, DoubleDouble& out)
+{
+    const QByteArray s = text.trimmed().toLatin1();
+    const DoubleDouble ten = { 10.0, 0.0 };
+    DoubleDouble value = { 0.0, 0.0 };
+    int i = 0, scale = 0, digits = 0;
+    const bool negative = i < s.size() && s[i] == '-';
+    if(i < s.size() && (s[i] == '-' || s[i] == '+'))
+        ++i;
+    bool point = false;
+    for(; i < s.size() && (isdigit(s[i]) || (s[i] == '.' && !point)); ++i)
+    {
+        if(s[i] == '.')
+        {
+            point = true;
+            continue;
+        }
+        const DoubleDouble d = { (double)(s[i] - '0'), 0.0 };
+        value = value * ten + d;
+        ++digits;
+        if(point)
+            --scale;
+    }
+    if(!digits)
+        return false;
+    if(i < s.size() && (s[i] == 'e' || s[i] == 'E'))
+    {
+        bool ok = false;
+        scale += s.mid(i + 1).toInt(&ok);
+        if(!ok)
+            return false;
+        i = s.size();
+    }
+    if(i != s.size() || abs(scale) > 400)
+        return false;
+
+    DoubleDouble power = { 1.0, 0.0 };
+    for(int k = 0; k < abs(scale); ++k)
+        power = power * ten;
+    value = scale < 0 ? value / power : value * power;
+    out = negative ? -value : value;
+    return true;
+}
+
+// ********************************************************************
+// Reference orbit
+//
+// Z_0 .. Z_M of the centre, iterated in double-double and stored rounded
+// to double. It stops early if the centre escapes; pixels that outlive
+// it are rebased onto the start of the orbit.
+class ReferenceOrbit
+{
+    std::vector<std::complex<double> > m_z;
+public:
+    ReferenceOrbit(const DoubleDouble& cx, const DoubleDouble& cy, int limit)
+    {
+        DoubleDouble x = { 0.0, 0.0 }, y = { 0.0, 0.0 };
+        m_z.reserve(limit + 1);
+        m_z.push_back(std::complex<double>(0, 0));
+        for(int i = 0; i < limit; ++i)
+        {
+            const DoubleDouble xy = x * y;
+            x = x * x - y * y + cx;
+            y = xy + xy + cy;
+            m_z.push_back(std::complex<double>(x.hi, y.hi));
+            if(mag2(m_z.back()) > escape2)
+                break;
+        }
+    }
+
+    // M, the last valid index
+    int length() const { return (int)m_z.size() - 1; }
+    const std::complex<double>& operator[](int m) const { return m_z[m]; }
+};
+
+// ********************************************************************
+// Bilinear approximation
+//
+// Near the reference a delta z follows z -> 2 Z_m z + z^2 + c, which is
+// z -> A z + B c while |z| < R keeps z^2 negligible. Two consecutive
+// approximations merge into one, so level l holds steps of 2^l
+// iterations starting at multiples of 2^l, each valid for |z| < r.
+struct Bla
+{
+    std::complex<double> a;
+    std::complex<double> b;
+    double r2;      // squared validity radius, compared against |z|^2
+};
+
+class BlaTable
+{
+    std::vector<std::vector<Bla> > m_levels;
+
+    static Bla merge(const Bla& x, const Bla& y, double max_dc)
+    {
+        const double ax = std::abs(x.a);
+        const double r = ax > 0.0 ? std::min(sqrt(x.r2), (sqrt(y.r2) - std::abs(x.b) * max_dc) / ax) : 0.0;
+        const Bla bla = { y.a * x.a, y.a * x.b + y.b, r > 0.0 ? r * r : 0.0 };
+        return bla;
+    }
+public:
+    // max_dc is the largest |c| of any pixel relative to the reference,
+    // tolerance the largest accepted |z^2| / |2 Z z| of a single step.
+    BlaTable(const ReferenceOrbit& ref, double max_dc, double tolerance)
+    {
+        m_levels.push_back(std::vector<Bla>(ref.length()));
+        for(int m = 0; m < ref.length(); ++m)
+        {
+            const double r = tolerance * 2.0 * std::abs(ref[m]);
+            const Bla bla = { 2.0 * ref[m], 1.0, r * r };
+            m_levels[0][m] = bla;
+        }
+        while(m_levels.back().size() >= 2)
+        {
+            const std::vector<Bla>& lower = m_levels.back();
+            std::vector<Bla> level(lower.size() / 2);
+            for(size_t j = 0; j < level.size(); ++j)
+                level[j] = merge(lower[2 * j], lower[2 * j + 1], max_dc);
+            m_levels.push_back(level);
+        }
+    }
+
+    int levels() const { return (int)m_levels.size(); }
+
+    // The longest approximation of at most max_length iterations that
+    // starts at reference index m and holds for |z|^2 = magz2, or 0.
+    // Single steps are left to the exact iteration. A step valid at
+    // level l + 1 is valid at level l, so the search stops at the first
+    // failure.
+    const Bla* lookup(int m, double magz2, int max_length, int& length) const
+    {
+        const Bla* best = 0;
+        for(int l = 1; l < (int)m_levels.size() && !(m & ((1 << l) - 1)) && (1 << l) <= max_length; ++l)
+        {
+            const size_t j = m >> l;
+            if(j >= m_levels[l].size() || magz2 >= m_levels[l][j].r2)
+                break;
+            best = &m_levels[l][j];
+            length = 1 << l;
+        }
+        return best;
+    }
+};
+
+// ********************************************************************
+// Pixels
+
+// Smooth iteration count mu of reference + dc, at least 1, or -1 if it
+// does not escape within limit. steps counts the loop trips for the statistics.
+static double perturbed_mu(const ReferenceOrbit& ref, const BlaTable& bla,
+                           const std::complex<double>& dc, int limit, long long& steps)
+{
+    const double offset = smooth_offset<Mandelbrot>();
+    std::complex<double> z(0, 0);
+    int m = 0, n = 0;
+    while(n < limit)
+    {
+        int length = 1;
+        if(const Bla* b = bla.lookup(m, mag2(z), limit - n, length))
+            z = b->a * z + b->b * dc;
+        else
+            z = (2.0 * ref[m] + z) * z + dc;
+        m += length;
+        n += length;
+        ++steps;
+
+        // Escape is tested on the full value; once that is smaller than
+        // the delta, or the reference ends, continue from the start of
+        // the reference instead, which keeps the delta small.
+        const std::complex<double> full = ref[m] + z;
+        const double magz2 = mag2(full);
+        if(magz2 > escape2)
+            return std::max(n + offset - escape_phase<Mandelbrot>(magz2), 1.0);
+        if(magz2 < mag2(z) || m == ref.length())
+        {
+            z = full;
+            m = 0;
+        }
+    }
+    return -1.0;
+}
+
+bool render_deep(const DeepSpec& spec, const QString& path)
+{
+    DoubleDouble cx, cy;
+    if(!parse_double_double(spec.center_x, cx) || !parse_double_double(spec.center_y, cy) ||
+       spec.radius <= 0.0 || spec.iterations < 1 || spec.width < 1 || spec.height < 1 || spec.tolerance < 0.0)
+        return false;
+
+    QElapsedTimer time;
+    time.start();
+    const double step = 2.0 * spec.radius / spec.height;
+    const double max_dc = 0.5 * std::sqrt((double)spec.width * spec.width + (double)spec.height * spec.height) * step;
+    const ReferenceOrbit ref(cx, cy, spec.iterations);
+    const BlaTable bla(ref, max_dc, spec.tolerance);
+    qDebug("reference orbit of %d iterations, %d approximation levels, %lld milliseconds",
+           ref.length(), bla.levels(), (long long)time.elapsed());
+
+    // Neighbouring rows cost about the same and far apart ones may not,
+    // so every job takes every parallelism-th row.
+    time.restart();
+    std::vector<double> mu((size_t)spec.width * spec.height);
+    long long steps[parallelism];
+    auto render_job = [&](int job) {
+        long long job_steps = 0;
+        for(int y = job; y < spec.height; y += parallelism)
+            for(int x = 0; x < spec.width; ++x)
+            {
+                const std::complex<double> dc((x - 0.5 * spec.width) * step, (y - 0.5 * spec.height) * step);
+                mu[(size_t)y * spec.width + x] = perturbed_mu(ref, bla, dc, spec.iterations, job_steps);
+            }
+        steps[job] = job_steps;
+    };
+    parallel_jobs(render_job);
+
+    long long total_steps = 0;
+    for(int i = 0; i < parallelism; ++i)
+        total_steps += steps[i];
+    qDebug("%d x %d pixels in %lld milliseconds, %lld steps", spec.width, spec.height, (long long)time.elapsed(), total_steps);
+
+    // Colour log(mu) over the escaped pixels, interior is black.
+    double min_result = 0.0, max_result = 0.0;
+    bool any = false;
+    for(size_t i = 0; i < mu.size(); ++i)
+        if(mu[i] > 0.0)
+        {
+            const double v = log(mu[i]);
+            min_result = any ? std::min(min_result, v) : v;
+            max_result = any ? std::max(max_result, v) : v;
+            any = true;
+        }
+    const Coloring coloring = { palettes[0], min_result, any ? max_result + 1e-9 : 1.0, 0.0 };
+    QImage image(spec.width, spec.height, QImage::Format_RGB32);
+    for(int y = 0; y < spec.height; ++y)
+    {
+        uint32_t* line = (uint32_t*)image.scanLine(y);
+        for(int x = 0; x < spec.width; ++x)
+        {
+            const double m = mu[(size_t)y * spec.width + x];
+            line[x] = m > 0.0 ? map_to_argb(log(m), coloring) : 0xff000000;
+        }
+    }
+    return image.save(path);
+}
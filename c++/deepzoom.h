@@ -0,0 +1,32 @@
+#ifndef DEEPZOOM_H
+#define DEEPZOOM_H
+
+#include <QString>
+
+// A bilinear approximation step is used while the z^2 term it drops is
+// at most this fraction of the linear term. At 2^-53 that is below
+// double rounding, so pictures match plain perturbation; 2^-24 skips
+// several times more iterations at the price of visible errors in the
+// slowest-escaping pixels.
+const static double exact_tolerance = 1.1102230246251565e-16;     // 2^-53
+
+// A Mandelbrot view of half height radius around a centre given as
+// decimal strings, so it can carry more digits than a double.
+struct DeepSpec
+{
+    QString center_x;
+    QString center_y;
+    double radius;
+    int iterations;
+    int width;
+    int height;
+    double tolerance;
+};
+
+// Iterates one reference orbit at the centre in double-double precision
+// and every pixel as a double delta from it, skipping ahead with a table
+// of bilinear approximations wherever they are accurate enough. Good down
+// to radii of about 1e-28, where double-double runs out of digits.
+bool render_deep(const DeepSpec& spec, const QString& path);
+
+#endif // DEEPZOOM_H
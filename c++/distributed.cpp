@@ -0,0 +1,343 @@
+#include "distributed.h"
+#include "recolor.h"
+#include <QtGui>
+#include <QDataStream>
+#include <string.h>
+
+const static int tile_size = 256;
+const static int leases_per_worker = 2;     // one rendering, one in the pipe
+const static int min_lease_ms = 2000;       // never re-issue a lease younger than this
+const static int lease_slack = 4;           // ... or younger than this many average tiles
+const static int watchdog_ms = 250;
+
+// The messages are QDataStream records:
+//
+//   coordinator -> worker   quint32 lease, QByteArray formula, double x0, y0, step, qint32 width, height
+//   worker -> coordinator   quint32 lease, QByteArray counts
+//
+// counts holds width x height SmoothCounts in host byte order, coordinator
+// and workers run the same binary on the same host.
+const static QDataStream::Version stream_version = QDataStream::Qt_5_0;
+
+// ********************************************************************
+// Coordinator
+Coordinator::Coordinator(const FarmSpec& spec, const QString& output, QObject* parent)
+    : QObject(parent), m_spec(spec), m_output(output),
+      m_vp(spec.formula->view(spec.width, spec.height)),
+      m_counts((size_t)spec.width * spec.height),
+      m_columns((spec.width + tile_size - 1) / tile_size),
+      m_rows((spec.height + tile_size - 1) / tile_size),
+      m_done(m_columns * m_rows, false),
+      m_remaining(m_columns * m_rows),
+      m_next_lease(0),
+      m_tile_nsecs(0), m_tiles_timed(0), m_issued(0), m_reissued(0), m_respawns(0)
+{
+    for(int tile = 0; tile < m_remaining; ++tile)
+        m_queue.append(tile);
+    connect(&m_server, SIGNAL(newConnection()), this, SLOT(workerConnected()));
+    connect(&m_watchdog, SIGNAL(timeout()), this, SLOT(checkLeases()));
+}
+
+Coordinator::~Coordinator()
+{
+    for(int i = 0; i < m_processes.size(); ++i)
+    {
+        m_processes[i]->disconnect(this);
+        if(!m_processes[i]->waitForFinished(3000))
+            m_processes[i]->kill();
+        delete m_processes[i];
+    }
+}
+
+bool Coordinator::start(const QString& address)
+{
+    QLocalServer::removeServer(address);
+    if(!m_server.listen(address))
+    {
+        qWarning("coordinator: cannot listen on %s", qPrintable(address));
+        return false;
+    }
+    qDebug("coordinator: %d tiles, workers connect to %s", m_remaining, qPrintable(m_server.fullServerName()));
+    m_clock.start();
+    m_watchdog.start(watchdog_ms);
+    for(int i = 0; i < m_spec.workers; ++i)
+        spawn();
+    return true;
+}
+
+// Workers on one host share its cores.
+void Coordinator::spawn()
+{
+    const int threads = std::max(QThread::idealThreadCount() / std::max(m_spec.workers, 1), 1);
+    QProcess* process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(processFinished(int,QProcess::ExitStatus)));
+    process->start(QCoreApplication::applicationFilePath(),
+                   QStringList() << "--worker" << m_server.fullServerName() << QString::number(threads));
+    m_processes.append(process);
+}
+
+Viewport Coordinator::tile_view(int tile) const
+{
+    const int left = tile % m_columns * tile_size;
+    const int top = tile / m_columns * tile_size;
+    const Viewport vp = { m_vp.x0 + left * m_vp.step, m_vp.y0 + top * m_vp.step, m_vp.step,
+                          std::min(tile_size, m_vp.width - left), std::min(tile_size, m_vp.height - top) };
+    return vp;
+}
+
+qint64 Coordinator::lease_timeout() const
+{
+    const qint64 floor = min_lease_ms * qint64(1000000);
+    if(!m_tiles_timed)
+        return floor;
+    return std::max(floor, lease_slack * m_tile_nsecs / m_tiles_timed);
+}
+
+void Coordinator::requeue(int tile)
+{
+    if(!m_done[tile] && !m_queue.contains(tile))
+        m_queue.prepend(tile);
+}
+
+void Coordinator::dispatch()
+{
+    for(QHash<QLocalSocket*, int>::iterator it = m_inflight.begin(); it != m_inflight.end(); ++it)
+        while(it.value() < leases_per_worker && !m_queue.isEmpty())
+        {
+            const int tile = m_queue.takeFirst();
+            if(!m_done[tile])
+            {
+                issue(it.key(), tile);
+                ++it.value();
+            }
+        }
+}
+
+void Coordinator::issue(QLocalSocket* worker, int tile)
+{
+    const quint32 id = m_next_lease++;
+    const Lease lease = { tile, worker, m_clock.nsecsElapsed(), false };
+    m_leases.insert(id, lease);
+    ++m_issued;
+
+    const Viewport vp = tile_view(tile);
+    QDataStream out(worker);
+    out.setVersion(stream_version);
+    out << id << QByteArray(m_spec.formula->name) << vp.x0 << vp.y0 << vp.step
+        << (qint32)vp.width << (qint32)vp.height;
+}
+
+void Coordinator::workerConnected()
+{
+    while(QLocalSocket* worker = m_server.nextPendingConnection())
+    {
+        m_inflight.insert(worker, 0);
+        connect(worker, SIGNAL(readyRead()), this, SLOT(readResult()));
+        connect(worker, SIGNAL(disconnected()), this, SLOT(workerGone()));
+    }
+    dispatch();
+}
+
+void Coordinator::readResult()
+{
+    QLocalSocket* worker = qobject_cast<QLocalSocket*>(sender());
+    if(!worker)
+        return;
+    QDataStream in(worker);
+    in.setVersion(stream_version);
+    for(;;)
+    {
+        in.startTransaction();
+        quint32 id;
+        QByteArray counts;
+        in >> id >> counts;
+        if(!in.commitTransaction())
+            break;
+
+        QHash<quint32, Lease>::iterator it = m_leases.find(id);
+        if(it == m_leases.end() || it->worker != worker)
+            continue;
+        const Lease lease = *it;
+        m_leases.erase(it);
+        --m_inflight[worker];
+        if(m_done[lease.tile])
+            continue;
+
+        const Viewport vp = tile_view(lease.tile);
+        if(counts.size() != (int)(vp.width * vp.height * sizeof(SmoothCount)))
+        {
+            qWarning("coordinator: bad result for tile %d", lease.tile);
+            requeue(lease.tile);
+            continue;
+        }
+        const SmoothCount* src = (const SmoothCount*)counts.constData();
+        const int left = lease.tile % m_columns * tile_size;
+        const int top = lease.tile / m_columns * tile_size;
+        for(int y = 0; y < vp.height; ++y)
+            std::copy(src + y * vp.width, src + (y + 1) * vp.width,
+                      &m_counts[(size_t)(top + y) * m_vp.width + left]);
+
+        m_done[lease.tile] = true;
+        --m_remaining;
+        m_tile_nsecs += m_clock.nsecsElapsed() - lease.issued;
+        ++m_tiles_timed;
+    }
+    if(!m_remaining)
+        finish();
+    else
+        dispatch();
+}
+
+void Coordinator::workerGone()
+{
+    QLocalSocket* worker = qobject_cast<QLocalSocket*>(sender());
+    if(!worker)
+        return;
+    m_inflight.remove(worker);
+    for(QHash<quint32, Lease>::iterator it = m_leases.begin(); it != m_leases.end(); )
+        if(it->worker == worker)
+        {
+            requeue(it->tile);
+            it = m_leases.erase(it);
+        }
+        else
+            ++it;
+    worker->deleteLater();
+    if(m_remaining)
+    {
+        dispatch();
+        check_workers();
+    }
+}
+
+void Coordinator::processFinished(int code, QProcess::ExitStatus status)
+{
+    if(!m_remaining)
+        return;
+    if(status == QProcess::CrashExit)
+        qWarning("coordinator: worker crashed");
+    else if(code != 0)
+        qWarning("coordinator: worker exited with code %d", code);
+    if(m_respawns < m_spec.workers)
+    {
+        ++m_respawns;
+        spawn();
+    }
+    else
+        check_workers();
+}
+
+// Gives up once every spawned worker is gone and none may be restarted.
+// Without spawned workers the coordinator waits for new ones indefinitely.
+void Coordinator::check_workers()
+{
+    if(!m_spec.workers || !m_inflight.isEmpty() || m_respawns < m_spec.workers)
+        return;
+    for(int i = 0; i < m_processes.size(); ++i)
+        if(m_processes[i]->state() != QProcess::NotRunning)
+            return;
+    qWarning("coordinator: no workers left, %d tiles unfinished", m_remaining);
+    QCoreApplication::exit(1);
+}
+
+void Coordinator::checkLeases()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    const qint64 timeout = lease_timeout();
+    for(QHash<quint32, Lease>::iterator it = m_leases.begin(); it != m_leases.end(); ++it)
+        if(!it->reissued && !m_done[it->tile] && now - it->issued > timeout)
+        {
+            it->reissued = true;
+            ++m_reissued;
+            requeue(it->tile);
+        }
+    dispatch();
+}
+
+void Coordinator::finish()
+{
+    m_watchdog.stop();
+    qDebug("coordinator: %d tiles in %lld milliseconds, %d leases, %d re-issued, %d workers restarted",
+           m_columns * m_rows, (long long)m_clock.elapsed(), m_issued, m_reissued, m_respawns);
+
+    // Closing the sockets is the workers' signal to exit.
+    const QList<QLocalSocket*> workers = m_inflight.keys();
+    for(int i = 0; i < workers.size(); ++i)
+    {
+        workers[i]->disconnect(this);
+        workers[i]->disconnectFromServer();
+    }
+    m_inflight.clear();
+
+    const int size = m_vp.width * m_vp.height;
+    Coloring coloring = { palettes[0], 0.0, 0.0, 0.0 };
+    smooth_range(&m_counts[0], size, m_spec.formula->offset, coloring.min_result, coloring.max_result);
+    QImage image(m_vp.width, m_vp.height, QImage::Format_RGB32);
+    recolor(&m_counts[0], size, m_spec.formula->offset, coloring, (uint32_t*)image.bits());
+    QCoreApplication::exit(image.save(m_output) ? 0 : 1);
+}
+
+// ********************************************************************
+// Worker
+RenderWorker::RenderWorker(int threads, QObject* parent)
+    : QObject(parent), m_renderer(create_renderer("qtconcurrent"))
+{
+    const RenderConfig config = { threads, 1, 0, 0 };
+    m_config = config;
+    connect(&m_socket, SIGNAL(readyRead()), this, SLOT(readLease()));
+    connect(&m_socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+}
+
+RenderWorker::~RenderWorker()
+{
+    delete m_renderer;
+}
+
+bool RenderWorker::connectTo(const QString& address)
+{
+    m_socket.connectToServer(address);
+    if(!m_socket.waitForConnected(5000))
+    {
+        qWarning("worker: cannot connect to %s", qPrintable(address));
+        return false;
+    }
+    return true;
+}
+
+void RenderWorker::readLease()
+{
+    QDataStream in(&m_socket);
+    in.setVersion(stream_version);
+    for(;;)
+    {
+        in.startTransaction();
+        quint32 id;
+        QByteArray name;
+        Viewport vp;
+        qint32 width, height;
+        in >> id >> name >> vp.x0 >> vp.y0 >> vp.step >> width >> height;
+        if(!in.commitTransaction())
+            break;
+        vp.width = width;
+        vp.height = height;
+
+        // An unknown formula or a bad size gets an empty reply, which the
+        // coordinator rejects and re-queues.
+        QByteArray counts;
+        const Formula* formula = find_formula(name.constData());
+        if(formula && width > 0 && height > 0 && width <= tile_size && height <= tile_size)
+        {
+            counts.resize(width * height * sizeof(SmoothCount));
+            m_renderer->render(*formula, vp, (SmoothCount*)counts.data(), m_config);
+        }
+        QDataStream out(&m_socket);
+        out.setVersion(stream_version);
+        out << id << counts;
+    }
+}
+
+void RenderWorker::disconnected()
+{
+    QCoreApplication::quit();
+}
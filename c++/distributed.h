@@ -0,0 +1,110 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+#include <vector>
+#include "renderer.h"
+
+// A frame rendered by a farm of worker processes.
+struct FarmSpec
+{
+    const Formula* formula;
+    int width;
+    int height;
+    int workers;        // processes to spawn, 0 waits for workers started by hand
+};
+
+// Splits a frame into tiles and leases them to worker processes over a
+// local socket, then assembles the SmoothCounts and writes a PNG.
+//
+// Every worker holds at most a couple of leases at a time. A lease that is
+// much older than the average tile is re-issued to another worker and
+// whichever result arrives first is kept; the leases of a worker that
+// disconnects go back to the front of the queue, and spawned workers that
+// crash are restarted.
+class Coordinator : public QObject
+{
+    Q_OBJECT
+
+    struct Lease
+    {
+        int tile;
+        QLocalSocket* worker;
+        qint64 issued;
+        bool reissued;  // the tile is queued again because this lease is late
+    };
+
+    FarmSpec m_spec;
+    QString m_output;
+    QLocalServer m_server;
+    QList<QProcess*> m_processes;
+    QTimer m_watchdog;
+    QElapsedTimer m_clock;
+
+    Viewport m_vp;
+    std::vector<SmoothCount> m_counts;
+    int m_columns;
+    int m_rows;
+    QList<int> m_queue;                     // tiles waiting for a lease
+    QVector<bool> m_done;
+    int m_remaining;
+    QHash<quint32, Lease> m_leases;
+    QHash<QLocalSocket*, int> m_inflight;   // leases held by each connected worker
+    quint32 m_next_lease;
+
+    // statistics
+    qint64 m_tile_nsecs;
+    int m_tiles_timed;
+    int m_issued;
+    int m_reissued;
+    int m_respawns;
+
+    void spawn();
+    void dispatch();
+    void issue(QLocalSocket* worker, int tile);
+    void requeue(int tile);
+    void check_workers();
+    Viewport tile_view(int tile) const;
+    qint64 lease_timeout() const;
+    void finish();
+private slots:
+    void workerConnected();
+    void readResult();
+    void workerGone();
+    void processFinished(int code, QProcess::ExitStatus status);
+    void checkLeases();
+public:
+    Coordinator(const FarmSpec& spec, const QString& output, QObject* parent = 0);
+    ~Coordinator();
+
+    // Listens on the local socket address and spawns spec.workers workers.
+    bool start(const QString& address);
+};
+
+// Connects to a Coordinator and renders the tiles it leases with the
+// QtConcurrent backend, until the coordinator hangs up.
+class RenderWorker : public QObject
+{
+    Q_OBJECT
+    QLocalSocket m_socket;
+    Renderer* m_renderer;
+    RenderConfig m_config;
+private slots:
+    void readLease();
+    void disconnected();
+public:
+    RenderWorker(int threads, QObject* parent = 0);
+    ~RenderWorker();
+
+    bool connectTo(const QString& address);
+};
+
+#endif // DISTRIBUTED_H
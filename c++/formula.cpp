@@ -0,0 +1,29 @@
+#include "formula.h"
+#include <string.h>
+
+template<class F>
+static Formula make_formula(const char* name, double x0, double y0, double size)
+{
+    const Formula formula = { name, F::conjugate_symmetric, smooth_offset<F>(), x0, y0, size,
+                              render_block<F, false>, render_block<F, true> };
+    return formula;
+}
+
+const Formula formulas[] =
+    { make_formula<Mandelbrot>("mandelbrot", -2.0, -1.5, 3.0) ,
+      make_formula<Multibrot<3> >("multibrot3", -1.5, -1.5, 3.0) ,
+      make_formula<Multibrot<4> >("multibrot4", -1.5, -1.5, 3.0) ,
+      make_formula<Julia<Dendrite> >("julia-dendrite", -1.5, -1.5, 3.0) ,
+      make_formula<Julia<DouadyRabbit> >("julia-rabbit", -1.5, -1.5, 3.0) ,
+      make_formula<Julia<SanMarco> >("julia-sanmarco", -1.75, -1.75, 3.5) ,
+      make_formula<BurningShip>("burningship", -2.5, -2.0, 3.5) };
+
+const int formula_count = sizeof(formulas) / sizeof(formulas[0]);
+
+const Formula* find_formula(const char* name)
+{
+    for(int i = 0; i < formula_count; ++i)
+        if(strcmp(formulas[i].name, name) == 0)
+            return &formulas[i];
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef FORMULA_H
+#define FORMULA_H
+
+#include "mandel.h"
+
+typedef void (*RenderBlock)(const Viewport& vp, SmoothCount* out, int beg, int end, int left, int right, RowStats* stats);
+
+// One compiled instantiation of the kernel per fractal. Picking a formula
+// is a table lookup done once per frame, the inner loop never dispatches.
+struct Formula
+{
+    const char* name;
+    bool conjugate_symmetric;
+    double offset;              // smooth_offset<F>() for decoding SmoothCounts
+    double x0, y0, size;        // default view, a size x size square
+    RenderBlock block;
+    RenderBlock counted_block;
+
+    Viewport view(int width, int height) const
+    {
+        const double step = size / std::max(width, height);
+        const Viewport vp = { x0, y0, step, width, height };
+        return vp;
+    }
+};
+
+extern const Formula formulas[];
+extern const int formula_count;
+
+// Returns 0 for an unknown name.
+const Formula* find_formula(const char* name);
+
+#endif // FORMULA_H
@@ -1,11 +1,209 @@
 #include <QApplication>
+#include <QScopedPointer>
+#include <QThread>
+#include <QFile>
+#include <QDir>
+#include <QImage>
+#include <QElapsedTimer>
 #include "mandelbrotview.h"
+#include "zoomanimation.h"
+#include "buddhabrot.h"
+#include "deepzoom.h"
+#include "batch.h"
+#include "recolor.h"
+#include "tileserver.h"
+#include "distributed.h"
+#include "renderstats.h"
+#include "autotune.h"
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
-    MandelbrotView w;
+    // cppmandel --serve <port|socket path>
+    if(argc > 2 && QString(argv[1]) == "--serve")
+    {
+        QCoreApplication a(argc, argv);
+        TileServer server;
+        if(!server.listen(a.arguments()[2]))
+            return 1;
+        return a.exec();
+    }
+
+    // cppmandel --coordinator <file.png> [workers [width height [formula]]]
+    if(argc > 2 && QString(argv[1]) == "--coordinator")
+    {
+        QCoreApplication a(argc, argv);
+        const QStringList args = a.arguments();
+        FarmSpec spec = { formulas, N, N, QThread::idealThreadCount() };
+        if(args.size() > 3)
+            spec.workers = args[3].toInt();
+        if(args.size() > 5)
+        {
+            spec.width = args[4].toInt();
+            spec.height = args[5].toInt();
+        }
+        if(args.size() > 6 && !(spec.formula = find_formula(qPrintable(args[6]))))
+        {
+            qWarning("unknown formula %s", qPrintable(args[6]));
+            return 1;
+        }
+        if(spec.width < 1 || spec.height < 1 || spec.workers < 0)
+            return 1;
+        Coordinator coordinator(spec, args[2]);
+        if(!coordinator.start(QString("cppmandel-%1").arg(a.applicationPid())))
+            return 1;
+        return a.exec();
+    }
+
+    // cppmandel --worker <socket path> [threads]
+    if(argc > 2 && QString(argv[1]) == "--worker")
+    {
+        QCoreApplication a(argc, argv);
+        const QStringList args = a.arguments();
+        RenderWorker worker(args.size() > 3 ? std::max(args[3].toInt(), 1) : QThread::idealThreadCount());
+        if(!worker.connectTo(args[2]))
+            return 1;
+        return a.exec();
+    }
+
+    // The offline renderers only write image files, so they run on a
+    // QCoreApplication and need no display.
+    const QString mode = argc > 1 ? QString(argv[1]) : QString();
+    const bool offline = mode == "--zoom" || mode == "--buddhabrot" || mode == "--deep" || mode == "--batch";
+    QScopedPointer<QCoreApplication> a(offline ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
+    const QStringList args = a->arguments();
+
+    // cppmandel --zoom <dir> [frames [center_x center_y end_radius]]
+    if(args.size() > 2 && args[1] == "--zoom")
+    {
+        ZoomSpec spec = { -0.743643887037151, 0.131825904205330, 1.5, 1.5e-5, 1000, 1000, 1000 };
+        if(args.size() > 3)
+            spec.frames = args[3].toInt();
+        if(args.size() > 6)
+        {
+            spec.center_x = args[4].toDouble();
+            spec.center_y = args[5].toDouble();
+            spec.end_radius = args[6].toDouble();
+        }
+        return render_zoom(spec, args[2]) ? 0 : 1;
+    }
+
+    // cppmandel --buddhabrot <file.png> [samples [limit_r limit_g limit_b]]
+    if(args.size() > 2 && args[1] == "--buddhabrot")
+    {
+        BuddhaSpec spec = { N, N, 100000000LL, { 5000, 500, 50 } };
+        if(args.size() > 3)
+            spec.samples = args[3].toLongLong();
+        if(args.size() > 6)
+            for(int i = 0; i < 3; ++i)
+                spec.limits[i] = args[4 + i].toInt();
+        return render_buddhabrot(spec, args[2]) ? 0 : 1;
+    }
+
+    // cppmandel --deep <file.png> <center_x> <center_y> <radius> [iterations [tolerance]]
+    if(args.size() > 5 && args[1] == "--deep")
+    {
+        DeepSpec spec = { args[3], args[4], args[5].toDouble(), 1000000, N, N, exact_tolerance };
+        if(args.size() > 6)
+            spec.iterations = args[6].toInt();
+        if(args.size() > 7)
+            spec.tolerance = args[7].toDouble();
+        return render_deep(spec, args[2]) ? 0 : 1;
+    }
+
+    // cppmandel --batch <list> <dir>, one "formula width height [x0 y0 size]"
+    // per line of list, written to dir/NNNNN.png
+    if(args.size() > 3 && args[1] == "--batch")
+    {
+        QFile list(args[2]);
+        if(!list.open(QIODevice::ReadOnly | QIODevice::Text))
+            return 1;
+        QVector<BatchJob> jobs;
+        while(!list.atEnd())
+        {
+            const QStringList words = QString(list.readLine()).split(' ', Qt::SkipEmptyParts);
+            if(words.size() < 3)
+                continue;
+            const Formula* formula = find_formula(qPrintable(words[0]));
+            const int width = words[1].toInt(), height = words[2].toInt();
+            if(!formula || width < 1 || height < 1)
+            {
+                qWarning("bad batch line: %s", qPrintable(words.join(' ').trimmed()));
+                return 1;
+            }
+            BatchJob job = { formula, formula->view(width, height) };
+            if(words.size() > 5)
+            {
+                job.vp.x0 = words[3].toDouble();
+                job.vp.y0 = words[4].toDouble();
+                job.vp.step = words[5].toDouble() / std::max(width, height);
+            }
+            jobs.append(job);
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        BatchRenderer batch(QThread::idealThreadCount());
+        const QVector<BatchResult> results = batch.render(jobs);
+        const qint64 elapsed = timer.nsecsElapsed();
+        qint64 busy = 0;
+        for(int i = 0; i < results.size(); ++i)
+        {
+            const BatchResult& r = results[i];
+            const Viewport& vp = jobs[i].vp;
+            const double offset = jobs[i].formula->offset;
+            const SmoothCount* counts = &(*r.buffer)[0];
+            Coloring coloring = { palettes[0], 0.0, 0.0, 0.0 };
+            smooth_range(counts, vp.width * vp.height, offset, coloring.min_result, coloring.max_result);
+            QImage image(vp.width, vp.height, QImage::Format_RGB32);
+            recolor(counts, vp.width * vp.height, offset, coloring, (uint32_t*)image.bits());
+            image.save(QDir(args[3]).filePath(QString("%1.png").arg(i, 5, 10, QChar('0'))));
+            qDebug("%5d %s %dx%d: %d tiles, %.2f ms from %.2f to %.2f ms", i, jobs[i].formula->name,
+                   vp.width, vp.height, r.tiles, r.busy / 1e6, r.start / 1e6, r.finish / 1e6);
+            busy += r.busy;
+            batch.release(r);
+        }
+        qDebug("%d images in %.2f ms, %.2f ms busy over %d threads", results.size(), elapsed / 1e6,
+               busy / 1e6, QThread::idealThreadCount());
+        return 0;
+    }
+
+    // cppmandel [--trace <file.json>] [--formula <name>] [--backend <name>] [--retune]
+    const Formula* formula = formulas;
+    QString trace, backend;
+    bool retune = false;
+    for(int i = 1; i < args.size(); ++i)
+    {
+        if(args[i] == "--retune")
+            retune = true;
+        else if(i + 1 == args.size())
+            break;
+        else if(args[i] == "--trace")
+            trace = args[++i];
+        else if(args[i] == "--backend")
+            backend = args[++i];
+        else if(args[i] == "--formula" && !(formula = find_formula(qPrintable(args[++i]))))
+        {
+            qWarning("unknown formula %s", qPrintable(args[i]));
+            return 1;
+        }
+    }
+
+    const Profile profile = autotune(*formula, backend, retune);
+    if(profile.backend.isEmpty())
+        return 1;
+    Renderer* renderer = create_renderer(profile.backend);
+    if(!renderer)
+    {
+        qWarning("backend %s is not available", qPrintable(profile.backend));
+        return 1;
+    }
+    if(!trace.isEmpty())
+        render_trace = new RenderTrace(trace);
+
+    MandelbrotView w(formula, renderer, profile.config);
     w.show();
     
-    return a.exec();
+    const int result = a->exec();
+    delete renderer;
+    return result;
 }
@@ -0,0 +1,415 @@
+#ifndef MANDEL_H
+#define MANDEL_H
+
+#include <complex>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <string.h>
+
+const static int parallelism = 16;
+
+// ********************************************************************
+// Mandelbrot
+const static int N = 1000;      // grid size
+const static int depth = 200;   // max iterations
+const static double escape2 = 400.0; // escape radius ^ 2
+
+template<class T>
+double mag2(const std::complex<T>& x)
+{
+    return x.real() * x.real() + x.imag() * x.imag();
+}
+
+// ********************************************************************
+// Formulas
+//
+// A formula policy supplies the starting z and the constant c for a
+// sample point p, and one iteration step. Everything is static and
+// inline, so each escape_time<F> instantiation compiles to its own loop
+// with the parameters folded in.
+template<int D>
+struct Power
+{
+    static std::complex<double> of(const std::complex<double>& z) { return z * Power<D - 1>::of(z); }
+};
+template<>
+struct Power<1>
+{
+    static std::complex<double> of(const std::complex<double>& z) { return z; }
+};
+
+// z = z^D + p, D = 2 is the Mandelbrot set.
+template<int D>
+struct Multibrot
+{
+    static const int degree = D;
+    static const bool conjugate_symmetric = true;
+    static std::complex<double> start(const std::complex<double>&) { return std::complex<double>(0, 0); }
+    static std::complex<double> param(const std::complex<double>& p) { return p; }
+    static std::complex<double> step(const std::complex<double>& z, const std::complex<double>& c)
+    {
+        return Power<D>::of(z) + c;
+    }
+};
+
+typedef Multibrot<2> Mandelbrot;
+
+// z = z^2 + C, starting from z = p. C is a type with constexpr re and im.
+template<class C>
+struct Julia
+{
+    static const int degree = 2;
+    static const bool conjugate_symmetric = C::im == 0.0;
+    static std::complex<double> start(const std::complex<double>& p) { return p; }
+    static std::complex<double> param(const std::complex<double>&) { return std::complex<double>(C::re, C::im); }
+    static std::complex<double> step(const std::complex<double>& z, const std::complex<double>& c)
+    {
+        return z * z + c;
+    }
+};
+
+struct Dendrite     { static constexpr double re = 0.0,    im = 1.0; };
+struct DouadyRabbit { static constexpr double re = -0.123, im = 0.745; };
+struct SanMarco     { static constexpr double re = -0.75,  im = 0.0; };
+
+// z = (|Re z| + i|Im z|)^2 + p
+struct BurningShip
+{
+    static const int degree = 2;
+    static const bool conjugate_symmetric = false;
+    static std::complex<double> start(const std::complex<double>&) { return std::complex<double>(0, 0); }
+    static std::complex<double> param(const std::complex<double>& p) { return p; }
+    static std::complex<double> step(const std::complex<double>& z, const std::complex<double>& c)
+    {
+        const std::complex<double> a(fabs(z.real()), fabs(z.imag()));
+        return a * a + c;
+    }
+};
+
+// ********************************************************************
+// Logarithms
+//
+// fast_log2() writes x as 2^e * m with m in [sqrt(1/2), sqrt(2)) using
+// integer operations on the bits and sums log2(m) = 2/ln2 * atanh(s),
+// s = (m - 1) / (m + 1), up to s^9. There are no branches or table
+// lookups, so loops over arrays of x vectorize. For positive normal x
+// the absolute error is below 1.1e-9 (|s| <= 0.172, first dropped term
+// 2/ln2 * s^11/11); x <= 0, denormals, infinities and NaN give garbage.
+const static double ln2 = 0.69314718055994531;
+
+inline double fast_log2(double x)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    // Subtracting the bits of sqrt(1/2) moves the exponent boundary to
+    // the mantissa sqrt(1/2), so the shifted difference is e.
+    const int e = (int)((int64_t)(bits - 0x3fe6a09e667f3bcdULL) >> 52);
+    bits -= (uint64_t)(int64_t)e << 52;
+    double m;
+    memcpy(&m, &bits, sizeof(m));
+
+    const double s = (m - 1.0) / (m + 1.0);
+    const double s2 = s * s;
+    const double p = 2.0 / ln2 + s2 * (2.0 / (3.0 * ln2) + s2 * (2.0 / (5.0 * ln2) +
+                     s2 * (2.0 / (7.0 * ln2) + s2 * (2.0 / (9.0 * ln2)))));
+    return e + s * p;
+}
+
+// The logarithms of the smooth colouring, fast_log2() when built with
+// CONFIG += fastlog. Its error moves frac by less than a hundredth of
+// its 1/32768 resolution, well below anything visible.
+#ifdef FAST_LOG
+inline double smooth_log2(double x) { return fast_log2(x); }
+#else
+inline double smooth_log2(double x) { return log2(x); }
+#endif
+
+// ********************************************************************
+// Smooth iteration counts
+//
+// The smooth count mu = k + 1 - log_d(log |z|) is stored in 4 bytes as k
+// and frac = log_d(log |z| / log R) in 1/32768ths, R being the escape
+// radius, so that mu = k + offset - frac / 32768 with
+// offset = 1 - log_d(log R). That is half of a double per pixel, and mu
+// is recovered to within 2e-5, far below one step of the colour map.
+struct SmoothCount
+{
+    uint16_t count;     // iterations, depth for points that did not escape
+    uint16_t frac;
+};
+
+const static double frac_scale = 32768.0;
+
+template<class F>
+inline double smooth_offset()
+{
+    return 1.0 - log(log(escape2) / 2.0) / log((double)F::degree);
+}
+
+// Ordered like mu, for finding the normalization range without logs.
+inline uint32_t smooth_key(const SmoothCount& c)
+{
+    return ((uint32_t)c.count << 16) | (uint32_t)(65535 - c.frac);
+}
+
+// log(mu), the value the colour map is applied to. Far outside the set
+// (|c| above about 55) mu drops to 1 or below, it is clamped to 1 so the
+// logarithm stays finite.
+inline double smooth_log(const SmoothCount& c, double offset)
+{
+    return smooth_log2(std::max(c.count + offset - c.frac / frac_scale, 1.0)) * ln2;
+}
+
+// log_d(log |z| / log R) for the first |z|^2 >= escape2, in [0, 1). All
+// logarithms are base 2, so the constant ones fold and log(2) cancels.
+// Callers clamp magz2 to at least escape2 for points that did not escape;
+// a max() in here would keep loops over it from vectorizing.
+template<class F>
+inline double escape_phase(double magz2)
+{
+    return smooth_log2(smooth_log2(magz2) * (1.0 / log2(escape2))) * (1.0 / log2((double)F::degree));
+}
+
+inline uint16_t quantize_phase(double t)
+{
+    return (uint16_t)std::min(t * frac_scale + 0.5, 65535.0);
+}
+
+// Iterates p at most limit times, returns the iteration count and the
+// last |z|^2 in magz2.
+template<class F>
+inline int iterate(const std::complex<double>& p, int limit, double& magz2)
+{
+    std::complex<double> z = F::start(p);
+    const std::complex<double> c = F::param(p);
+    int i = 0;
+    for(; i < limit && (magz2 = mag2(z)) < escape2 ; ++i)
+        z = F::step(z, c);
+    return i;
+}
+
+template<class F>
+inline SmoothCount escape_time(const std::complex<double>& p)
+{
+    double magz2;
+    const int i = iterate<F>(p, depth, magz2);
+    const SmoothCount count = { (uint16_t)i, quantize_phase(escape_phase<F>(std::max(magz2, escape2))) };
+    return count;
+}
+
+inline double mandel(const std::complex<double>& z0)
+{
+    return smooth_log(escape_time<Mandelbrot>(z0), smooth_offset<Mandelbrot>());
+}
+
+// A width x height grid of samples, pixel (x, y) sits at
+// (x0 + x * step, y0 + y * step).
+struct Viewport
+{
+    double x0;
+    double y0;
+    double step;
+    int width;
+    int height;
+};
+
+// Work done by render_block<F, true>, for instrumentation.
+struct RowStats
+{
+    uint64_t iterations;
+    int escaped;
+};
+
+const static int phase_span = 256;   // pixels whose logarithms are taken together
+
+// Fills columns [left, right) of rows [beg, end), row by row so every
+// inner loop walks contiguous memory. Each span of a row is iterated
+// first and its phases computed afterwards in one branch-free loop, which
+// the compiler can vectorize.
+template<class F, bool Counted>
+void render_block(const Viewport& vp, SmoothCount* out, int beg, int end, int left, int right, RowStats* stats)
+{
+    double magz2[phase_span];
+    double phase[phase_span];
+    for(int y = beg; y < end; ++y)
+    {
+        const double im = vp.y0 + y * vp.step;
+        SmoothCount* row = out + (size_t)y * vp.width;
+        for(int x0 = left; x0 < right; x0 += phase_span)
+        {
+            const int n = std::min(right - x0, phase_span);
+            for(int i = 0; i < n; ++i)
+            {
+                row[x0 + i].count = (uint16_t)iterate<F>(std::complex<double>(vp.x0 + (x0 + i) * vp.step, im), depth, magz2[i]);
+                magz2[i] = std::max(magz2[i], escape2);
+                if(Counted)
+                {
+                    stats->iterations += row[x0 + i].count;
+                    if(row[x0 + i].count < depth)
+                        ++stats->escaped;
+                }
+            }
+            for(int i = 0; i < n; ++i)
+                phase[i] = escape_phase<F>(magz2[i]);
+            for(int i = 0; i < n; ++i)
+                row[x0 + i].frac = quantize_phase(phase[i]);
+        }
+    }
+}
+
+template<class F, bool Counted>
+void render_rows(const Viewport& vp, SmoothCount* out, int beg, int end, RowStats* stats)
+{
+    render_block<F, Counted>(vp, out, beg, end, 0, vp.width, stats);
+}
+
+// Formulas that are conjugate_symmetric are symmetric about the real
+// axis, so a row whose imaginary part is the negation of another row's
+// is the same row. Only rows [first, last) need to be computed, every
+// other row y is a copy of row sum - y.
+struct MirrorPlan
+{
+    int first;
+    int last;
+    int sum;
+};
+
+inline MirrorPlan plan_mirror(const Viewport& vp)
+{
+    MirrorPlan plan = { 0, vp.height, 0 };
+
+    // Rows y and y' mirror each other when y + y' = -2 * y0 / step. Only
+    // mirror when that is a whole number, otherwise the mirrored samples
+    // would not land on the grid.
+    const double s = -2.0 * vp.y0 / vp.step;
+    const double sum = floor(s + 0.5);
+    if(fabs(s - sum) > 1e-9 * std::max(1.0, fabs(s)) || sum < 1 || sum > 2.0 * vp.height - 3)
+        return plan;
+
+    // Keep the computed rows contiguous by mirroring into whichever side
+    // of the axis is shorter.
+    plan.sum = (int)sum;
+    if(plan.sum >= vp.height - 1)
+        plan.last = plan.sum / 2 + 1;
+    else
+        plan.first = (plan.sum + 1) / 2;
+    return plan;
+}
+
+template<class T>
+void mirror_rows(const MirrorPlan& plan, int width, int height, T* out)
+{
+    for(int y = 0; y < plan.first; ++y)
+        std::copy(out + (size_t)(plan.sum - y) * width, out + (size_t)(plan.sum - y + 1) * width, out + (size_t)y * width);
+    for(int y = plan.last; y < height; ++y)
+        std::copy(out + (size_t)(plan.sum - y) * width, out + (size_t)(plan.sum - y + 1) * width, out + (size_t)y * width);
+}
+
+template<class F>
+void render(const Viewport& vp, SmoothCount* out)
+{
+    MirrorPlan plan = { 0, vp.height, 0 };
+    if(F::conjugate_symmetric)
+        plan = plan_mirror(vp);
+    render_rows<F, false>(vp, out, plan.first, plan.last, 0);
+    mirror_rows(plan, vp.width, vp.height, out);
+}
+
+// ********************************************************************
+// Color mapping
+const static double color_map[][3] =
+    { { 0.0, 0.0, 0.5 } ,
+      { 0.0, 0.0, 1.0 } ,
+      { 0.0, 0.5, 1.0 } ,
+      { 0.0, 1.0, 1.0 } ,
+      { 0.5, 1.0, 0.5 } ,
+      { 1.0, 1.0, 0.0 } ,
+      { 1.0, 0.5, 0.0 } ,
+      { 1.0, 0.0, 0.0 } ,
+      { 0.5, 0.0, 0.0 } ,
+      { 0.5, 0.0, 0.0 } ,
+      { 1.0, 0.0, 0.0 } ,
+      { 1.0, 0.5, 0.0 } ,
+      { 1.0, 1.0, 0.0 } ,
+      { 0.5, 1.0, 0.5 } ,
+      { 0.0, 1.0, 1.0 } ,
+      { 0.0, 0.5, 1.0 } ,
+      { 0.0, 0.0, 1.0 } ,
+      { 0.0, 0.0, 0.5 } ,
+      { 0.0, 0.0, 0.0 } };
+
+inline int interpolate(const double& d, const double& v0, const double& v1)
+{
+    return int((d * (v1 - v0) + v0) * 255.0);
+}
+
+const static double grey_map[][3] =
+    { { 0.0, 0.0, 0.0 } ,
+      { 1.0, 1.0, 1.0 } ,
+      { 0.0, 0.0, 0.0 } };
+
+const static double fire_map[][3] =
+    { { 0.0, 0.0, 0.0 } ,
+      { 0.5, 0.0, 0.0 } ,
+      { 1.0, 0.3, 0.0 } ,
+      { 1.0, 0.8, 0.2 } ,
+      { 1.0, 1.0, 0.9 } ,
+      { 1.0, 0.8, 0.2 } ,
+      { 1.0, 0.3, 0.0 } ,
+      { 0.5, 0.0, 0.0 } ,
+      { 0.0, 0.0, 0.0 } };
+
+struct Palette
+{
+    const double (*colors)[3];
+    int stops;
+};
+
+const static Palette palettes[] =
+    { { color_map, sizeof(color_map) / sizeof(color_map[0]) - 1 } ,
+      { fire_map, sizeof(fire_map) / sizeof(fire_map[0]) - 1 } ,
+      { grey_map, sizeof(grey_map) / sizeof(grey_map[0]) - 1 } };
+
+const static int palette_count = sizeof(palettes) / sizeof(palettes[0]);
+
+// Everything needed to turn log(mu) into a colour. Changing any of it
+// only needs the stored SmoothCounts, not another render.
+struct Coloring
+{
+    Palette palette;
+    double min_result;  // log(mu) mapped to the first stop
+    double max_result;  // log(mu) mapped to black
+    double cycle;       // colour offset in stops, wraps around the palette
+};
+
+// Non-finite values, and everything when max_result <= min_result, map
+// to black.
+inline uint32_t map_to_argb(double x, const Coloring& coloring)
+{
+    const double range = coloring.max_result - coloring.min_result;
+    if(!std::isfinite(x) || !(range > 0.0))
+        return 0xff000000;
+    x = (x - coloring.min_result) / range;
+    if(!(x < 1.0))
+        return 0xff000000;
+    const int stops = coloring.palette.stops;
+    x = std::max(x, 0.0) * stops + coloring.cycle;
+    x -= floor(x / stops) * stops;
+    int bin = std::min((int) x, stops - 1);
+    const double* c0 = coloring.palette.colors[bin];
+    const double* c1 = coloring.palette.colors[bin+1];
+    double d = x - bin;
+    int r = interpolate(d, c0[0], c1[0]);
+    int g = interpolate(d, c0[1], c1[1]);
+    int b = interpolate(d, c0[2], c1[2]);
+    return b | (g << 8) | (r << 16) | 0xff000000;
+}
+
+inline uint32_t map_to_argb(double x, double min_result, double max_result)
+{
+    const Coloring coloring = { palettes[0], min_result, max_result, 0.0 };
+    return map_to_argb(x, coloring);
+}
+
+#endif // MANDEL_H
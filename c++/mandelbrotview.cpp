@@ -1,178 +1,208 @@
 #include "MandelbrotView.h"
+#include "renderer.h"
+#include "renderstats.h"
+#include "recolor.h"
 #include <QtGui>
-#include <complex>
-#include <algorithm>
-#include <cmath>
-#include <stdint.h>
 #include <QtConcurrent>
 
-const static int parallelism = 16;
+const static int frame_interval = 16;    // milliseconds between pacing ticks
+const static double cycle_speed = 0.05;  // palette stops per tick while cycling
 
-// ********************************************************************
-// Mandelbrot
-const static int N = 1000;      // grid size
-const static int depth = 200;   // max iterations
-const static double escape2 = 400.0; // escape radius ^ 2
+static SmoothCount counts[N*N];
 
-inline double trans_x(int x)
-{
-    return 3.0 * ((double)x / N) - 2.0;
-}
-inline double trans_y(int y)
+void do_mandel(const Formula* formula, Renderer* renderer, const RenderConfig& config, const Viewport& vp)
 {
-    return 3.0 * ((double)y / N) - 1.5;
-}
+    if(render_trace)
+        render_trace->begin();
 
-template<class T>
-double mag2(const std::complex<T>& x)
-{
-    return x.real() * x.real() + x.imag() * x.imag();
-}
+    renderer->render(*formula, vp, counts, config);
 
-inline double mandel(int idx)
-{
-    const std::complex<double> z0(trans_x(idx % N), trans_y(idx / N));
-    std::complex<double> z(0, 0);
-    int k = 0;
-    double magz2;
-    for(; k < depth && (magz2 = mag2(z)) < escape2 ; ++k)
-        z = z * z + z0;
-    return log(k + 1.0 - log(log(std::max(magz2, escape2)) / 2.0) / log(2.0));
+    if(render_trace)
+        render_trace->end();
 }
 
 // ********************************************************************
-// Color mapping
-const static double color_map[][3] =
-    { { 0.0, 0.0, 0.5 } ,
-      { 0.0, 0.0, 1.0 } ,
-      { 0.0, 0.5, 1.0 } ,
-      { 0.0, 1.0, 1.0 } ,
-      { 0.5, 1.0, 0.5 } ,
-      { 1.0, 1.0, 0.0 } ,
-      { 1.0, 0.5, 0.0 } ,
-      { 1.0, 0.0, 0.0 } ,
-      { 0.5, 0.0, 0.0 } ,
-      { 0.5, 0.0, 0.0 } ,
-      { 1.0, 0.0, 0.0 } ,
-      { 1.0, 0.5, 0.0 } ,
-      { 1.0, 1.0, 0.0 } ,
-      { 0.5, 1.0, 0.5 } ,
-      { 0.0, 1.0, 1.0 } ,
-      { 0.0, 0.5, 1.0 } ,
-      { 0.0, 0.0, 1.0 } ,
-      { 0.0, 0.0, 0.5 } ,
-      { 0.0, 0.0, 0.0 } };
-
-inline int interpolate(const double& d, const double& v0, const double& v1)
-{
-    return int((d * (v1 - v0) + v0) * 255.0);
-}
-
-static double min_result = 0.0;
-static double max_result = 0.0;
-
-const static int stops = sizeof(color_map) / sizeof(color_map[0]) - 1;
-
-inline uint32_t map_to_argb(double x)
+// Qt
+MandelbrotView::MandelbrotView(const Formula* formula, Renderer* renderer, const RenderConfig& config, QWidget *parent) :
+    QWidget(parent),
+    m_formula(formula),
+    m_renderer(renderer),
+    m_config(config),
+    m_front(0),
+    m_ready(0),
+    m_frame_ms(0),
+    m_counts_view(formula->view(N, N)),
+    m_view(formula->view(N, N)),
+    m_dirty(true),
+    m_moved(false),
+    m_recolor(false),
+    m_cycling(false),
+    m_palette(0)
 {
-    x = (x - min_result) / (max_result - min_result) * stops;
-    int bin = (int) x;
-    if(bin >= stops)
-        return 0xff000000;
-    else
+    const Coloring coloring = { palettes[m_palette], 0.0, 0.0, 0.0 };
+    m_coloring = coloring;
+    m_range[0] = m_range[1] = 0.0;
+    setGeometry(QRect(0, 0, N, N));
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setFocusPolicy(Qt::StrongFocus);
+    for(int i = 0; i < 2; ++i)
     {
-        const double& r0 = color_map[bin][0];
-        const double& g0 = color_map[bin][1];
-        const double& b0 = color_map[bin][2];
-        const double& r1 = color_map[bin+1][0];
-        const double& g1 = color_map[bin+1][1];
-        const double& b1 = color_map[bin+1][2];
-        double d = x - bin;
-        int r = interpolate(d, r0, r1);
-        int g = interpolate(d, g0, g1);
-        int b = interpolate(d, b0, b1);
-        return b | (g << 8) | (r << 16) | 0xff000000;
+        m_frames[i] = QImage(N, N, QImage::Format_RGB32);
+        m_frames[i].fill(Qt::black);
+        m_frame_views[i] = m_view;
     }
+    m_pacer.setTimerType(Qt::PreciseTimer);
+    connect(&m_pacer, SIGNAL(timeout()), this, SLOT(tick()));
+    m_pacer.start(frame_interval);
 }
 
-static double   log_count[N*N];
-static uint32_t argb_array[N*N];
-
-void do_mandel_range(int beg, int end)
-{
-    for(int idx = beg; idx < end; ++idx)
-        log_count[idx] = mandel(idx);
-}
-void do_map_to_argb_range(int beg, int end)
+MandelbrotView::~MandelbrotView()
 {
-    for(int i = beg; i < end; ++i)
-        argb_array[i] = map_to_argb(log_count[i]);
+    m_pacer.stop();
+    m_render.waitForFinished();
 }
 
-const static int job_size = N*N / parallelism;
-const int worker_threads = parallelism - 1;
-
-void do_mandel()
+void MandelbrotView::tick()
 {
-    if(parallelism > 1)
+    // Swap a finished back buffer in. The next render is only started
+    // below, after the swap, so it never writes the frame being painted.
+    // A job sets m_ready before its future finishes, so checking the
+    // future first means an idle worker's frame is always swapped before
+    // another job is given the back buffer.
+    const bool idle = m_render.isFinished();
+    if(m_ready.loadAcquire())
     {
-        QFuture<void> results[worker_threads];
-        for(int i = 0; i < worker_threads; ++i)
-            results[i] = QtConcurrent::run(do_mandel_range, job_size * i, job_size * (i + 1));
-
-        do_mandel_range(job_size * worker_threads, N*N);
+        m_ready.storeRelease(0);
+        const int front = 1 - m_front.loadAcquire();
+        m_front.storeRelease(front);
+        m_elapsed = QString("%1 milliseconds (%2)").arg(m_frame_ms).arg(m_renderer->name());
+        if(render_trace)
+        {
+            if(!render_trace->write())
+                qWarning("could not write render trace");
+            qDebug("%s", qPrintable(render_trace->summary()));
+        }
+        if(!m_moved)
+            update(frame_rect(front) | m_painted);
+    }
+    if(m_moved)
+    {
+        m_moved = false;
+        update();
+    }
 
-        for(int i = 0; i < worker_threads; ++i)
-            results[i].waitForFinished();
+    if(m_cycling)
+    {
+        m_coloring.cycle += cycle_speed;
+        m_recolor = true;
     }
-    else
-        do_mandel_range(0, N*N);
-}
-void do_map_to_argb()
-{
-    min_result = *(std::min_element(log_count, log_count + N*N));
-    max_result = *(std::max_element(log_count, log_count + N*N));
 
-    if(parallelism > 1)
+    if(!idle)
+        return;
+    const int back = 1 - m_front.loadAcquire();
+    uint32_t* argb = (uint32_t*)m_frames[back].bits();
+    if(m_dirty)
     {
-        QFuture<void> results[worker_threads];
-        for(int i = 0; i < worker_threads; ++i)
-            results[i] = QtConcurrent::run(do_map_to_argb_range, job_size * i, job_size * (i + 1));
+        m_dirty = m_recolor = false;
+        const Viewport vp = m_view;
+        const Coloring coloring = m_coloring;
+        m_frame_views[back] = m_counts_view = vp;
+        m_render = QtConcurrent::run([this, vp, coloring, argb]() {
+            QElapsedTimer time;
+            time.start();
+            do_mandel(m_formula, m_renderer, m_config, vp);
+            Coloring fitted = coloring;
+            smooth_range(counts, N*N, m_formula->offset, fitted.min_result, fitted.max_result);
+            recolor(counts, N*N, m_formula->offset, fitted, argb);
+            m_range[0] = fitted.min_result;
+            m_range[1] = fitted.max_result;
+            m_frame_ms = (int)time.elapsed();
+            m_ready.storeRelease(1);
+        });
+    }
+    else if(m_recolor)
+    {
+        // Same counts, new colours: no iterations.
+        m_recolor = false;
+        Coloring coloring = m_coloring;
+        coloring.min_result = m_range[0];
+        coloring.max_result = m_range[1];
+        m_frame_views[back] = m_counts_view;
+        m_render = QtConcurrent::run([this, coloring, argb]() {
+            QElapsedTimer time;
+            time.start();
+            recolor(counts, N*N, m_formula->offset, coloring, argb);
+            m_frame_ms = (int)time.elapsed();
+            m_ready.storeRelease(1);
+        });
+    }
+}
 
-        do_map_to_argb_range(job_size * worker_threads, N*N);
+// Where frame has to be drawn for its viewport to line up with m_view.
+QRect MandelbrotView::frame_rect(int frame) const
+{
+    const Viewport& f = m_frame_views[frame];
+    const double scale = f.step / m_view.step;
+    return QRect(qRound((f.x0 - m_view.x0) / m_view.step),
+                 qRound((f.y0 - m_view.y0) / m_view.step),
+                 qRound(f.width * scale),
+                 qRound(f.height * scale));
+}
 
-        for(int i = 0; i < worker_threads; ++i)
-            results[i].waitForFinished();
-    }
-    else
-        do_map_to_argb_range(0, N*N);
+void MandelbrotView::wheelEvent(QWheelEvent * evt)
+{
+    // Zoom about the point under the cursor.
+    const double factor = pow(0.8, evt->angleDelta().y() / 120.0);
+    const QPointF pos = evt->position();
+    const double re = m_view.x0 + pos.x() * m_view.step;
+    const double im = m_view.y0 + pos.y() * m_view.step;
+    m_view.step *= factor;
+    m_view.x0 = re - pos.x() * m_view.step;
+    m_view.y0 = im - pos.y() * m_view.step;
+    m_dirty = m_moved = true;
 }
 
-// ********************************************************************
-// Qt
-MandelbrotView::MandelbrotView(QWidget *parent) :
-    QWidget(parent)
+void MandelbrotView::keyPressEvent(QKeyEvent * evt)
 {
-    setGeometry(QRect(0, 0, N, N));
-    QTime time;
-    time.start();
+    switch(evt->key())
     {
-        do_mandel();
-        do_map_to_argb();
+    case Qt::Key_P:
+        m_palette = (m_palette + 1) % palette_count;
+        m_coloring.palette = palettes[m_palette];
+        m_recolor = true;
+        break;
+    case Qt::Key_C:
+        m_cycling = !m_cycling;
+        break;
+    default:
+        QWidget::keyPressEvent(evt);
     }
-    m_elapsed = QString("%1 milliseconds").arg(time.elapsed());
-    m_image = new QImage((uchar*)argb_array, N, N, QImage::Format_RGB32);
 }
 
-MandelbrotView::~MandelbrotView()
+void MandelbrotView::mousePressEvent(QMouseEvent * evt)
+{
+    m_drag = evt->pos();
+}
+
+void MandelbrotView::mouseMoveEvent(QMouseEvent * evt)
 {
-    delete m_image;
+    if(!(evt->buttons() & Qt::LeftButton))
+        return;
+    const QPoint delta = evt->pos() - m_drag;
+    m_drag = evt->pos();
+    m_view.x0 -= delta.x() * m_view.step;
+    m_view.y0 -= delta.y() * m_view.step;
+    m_dirty = m_moved = true;
 }
 
 void MandelbrotView::paintEvent(QPaintEvent * evt)
 {
-    QPainter painter(this);    
-    painter.drawImage(0, 0, *m_image);
-    painter.setPen(Qt::white);    
+    const QImage& frame = m_frames[m_front.loadAcquire()];
+    const QRect target = frame_rect(m_front.loadAcquire());
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+    painter.drawImage(target, frame);
+    painter.setPen(Qt::white);
     painter.drawStaticText(20, 20, m_elapsed);
+    m_painted = target;
 }
@@ -2,15 +2,59 @@
 #define MANDELBROTVIEW_H
 
 #include <QWidget>
+#include <QImage>
+#include <QTimer>
+#include <QFuture>
+#include <QAtomicInt>
+#include "renderer.h"
 
+// Renders in the background into a back framebuffer while the GUI paints
+// the front one. A pacing timer swaps finished frames in, starts at most
+// one new render per tick and redraws only the area that changed. While
+// a render is in flight the front frame is drawn scaled and shifted to
+// the current view, so dragging and zooming stay at display rate.
 class MandelbrotView : public QWidget
 {
     Q_OBJECT
+    const Formula* m_formula;
+    Renderer* m_renderer;
+    RenderConfig m_config;
+
+    // Workers only write m_frames[1 - m_front], paintEvent() only reads
+    // m_frames[m_front]. m_ready is set once the back buffer is complete.
+    QImage m_frames[2];
+    Viewport m_frame_views[2];
+    QAtomicInt m_front;
+    QAtomicInt m_ready;
+    int m_frame_ms;
+    QFuture<void> m_render;
+
+    // The stored counts, their viewport and log(mu) range, for recolouring.
+    Viewport m_counts_view;
+    double m_range[2];
+    Coloring m_coloring;
+
+    QTimer m_pacer;
+    Viewport m_view;
+    bool m_dirty;       // m_view changed since the last render started
+    bool m_moved;       // m_view changed since the last paint
+    bool m_recolor;     // m_coloring changed since the last frame started
+    bool m_cycling;     // C toggles palette cycling
+    int m_palette;      // P steps through palettes[]
+    QPoint m_drag;
+    QRect m_painted;    // where the front frame was last drawn
     QString m_elapsed;
-    QImage* m_image;
+
+    QRect frame_rect(int frame) const;
     void paintEvent(QPaintEvent * evt);
+    void wheelEvent(QWheelEvent * evt);
+    void keyPressEvent(QKeyEvent * evt);
+    void mousePressEvent(QMouseEvent * evt);
+    void mouseMoveEvent(QMouseEvent * evt);
+private slots:
+    void tick();
 public:
-    MandelbrotView(QWidget *parent = 0);
+    MandelbrotView(const Formula* formula, Renderer* renderer, const RenderConfig& config, QWidget *parent = 0);
     ~MandelbrotView();
 };
 
@@ -0,0 +1,36 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <QtConcurrent>
+#include "mandel.h"
+
+// Kept out of mandel.h, which stays free of Qt so that the kernels can be
+// compiled on their own.
+
+// Calls f(job) for every job in [0, parallelism), the last one on the
+// calling thread and the others on the global thread pool, and returns
+// once all of them have.
+template<class F>
+void parallel_jobs(F f)
+{
+    const int workers = parallelism - 1;
+    QFuture<void> results[parallelism];
+    for(int i = 0; i < workers; ++i)
+        results[i] = QtConcurrent::run([&f, i]() { f(i); });
+
+    f(workers);
+
+    for(int i = 0; i < workers; ++i)
+        results[i].waitForFinished();
+}
+
+// Splits [0, count) into parallelism ranges and calls f(beg, end) for
+// each, the last range taking the remainder.
+template<class F>
+void parallel_range(int count, F f)
+{
+    const int job = count / parallelism;
+    parallel_jobs([&](int i) { f(job * i, i == parallelism - 1 ? count : job * (i + 1)); });
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,32 @@
+#include "recolor.h"
+#include "parallel.h"
+
+static bool smooth_less(const SmoothCount& a, const SmoothCount& b)
+{
+    return smooth_key(a) < smooth_key(b);
+}
+
+void smooth_range(const SmoothCount* counts, int size, double offset,
+                  double& min_result, double& max_result)
+{
+    min_result = smooth_log(*std::min_element(counts, counts + size, smooth_less), offset);
+    max_result = smooth_log(*std::max_element(counts, counts + size, smooth_less), offset);
+    // A frame of one value, all inside the set say, maps to black.
+    if(max_result <= min_result)
+        min_result = max_result - 1.0;
+}
+
+static void recolor_range(const SmoothCount* counts, double offset, const Coloring& coloring,
+                          uint32_t* argb, int beg, int end)
+{
+    for(int i = beg; i < end; ++i)
+        argb[i] = map_to_argb(smooth_log(counts[i], offset), coloring);
+}
+
+void recolor(const SmoothCount* counts, int size, double offset,
+             const Coloring& coloring, uint32_t* argb)
+{
+    parallel_range(size, [=](int beg, int end) {
+        recolor_range(counts, offset, coloring, argb, beg, end);
+    });
+}
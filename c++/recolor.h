@@ -0,0 +1,19 @@
+#ifndef RECOLOR_H
+#define RECOLOR_H
+
+#include "mandel.h"
+
+// Colouring works from stored SmoothCounts only, so a new palette,
+// normalization or colour offset costs one pass over the pixels and no
+// iterations.
+
+// The range of log(mu) over counts, what a Coloring is normally fitted to.
+// It is never empty.
+void smooth_range(const SmoothCount* counts, int size, double offset,
+                  double& min_result, double& max_result);
+
+// Maps counts to argb in parallel.
+void recolor(const SmoothCount* counts, int size, double offset,
+             const Coloring& coloring, uint32_t* argb);
+
+#endif // RECOLOR_H
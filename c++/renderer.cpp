@@ -0,0 +1,56 @@
+#include "renderer.h"
+#include "renderstats.h"
+
+Renderer* create_qtconcurrent_renderer();
+#ifdef HAVE_TBB
+Renderer* create_tbb_renderer();
+#endif
+#ifdef HAVE_OPENCL
+Renderer* create_opencl_renderer();
+#endif
+
+void render_band(const Formula& formula, const Viewport& vp, SmoothCount* out,
+                 int beg, int end, int left, int right)
+{
+    if(!render_trace)
+    {
+        formula.block(vp, out, beg, end, left, right, 0);
+        return;
+    }
+    RowStats counts = { 0, 0 };
+    TileStats stats = { beg, end, left, right, 0, 0, 0, 0, render_trace->now(), 0 };
+    formula.counted_block(vp, out, beg, end, left, right, &counts);
+    stats.finish = render_trace->now();
+    stats.iterations = counts.iterations;
+    stats.escaped = counts.escaped;
+    stats.interior = (end - beg) * (right - left) - counts.escaped;
+    render_trace->record(stats);
+}
+
+QStringList renderer_names()
+{
+    QStringList names;
+    names << "qtconcurrent";
+#ifdef HAVE_TBB
+    names << "tbb";
+#endif
+#ifdef HAVE_OPENCL
+    names << "opencl";
+#endif
+    return names;
+}
+
+Renderer* create_renderer(const QString& name)
+{
+    if(name == "qtconcurrent")
+        return create_qtconcurrent_renderer();
+#ifdef HAVE_TBB
+    if(name == "tbb")
+        return create_tbb_renderer();
+#endif
+#ifdef HAVE_OPENCL
+    if(name == "opencl")
+        return create_opencl_renderer();
+#endif
+    return 0;
+}
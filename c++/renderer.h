@@ -0,0 +1,59 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "formula.h"
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// How a backend splits a frame. Each backend only looks at the fields
+// that apply to it.
+struct RenderConfig
+{
+    int threads;      // worker threads (CPU backends)
+    int tile_rows;    // rows per scheduled job (CPU backends)
+    int local_size;   // work-group size (OpenCL)
+    int tile_cols;    // columns per scheduled job, 0 for whole rows (TBB)
+};
+
+// A way of running the escape-time kernel over a Viewport. The backends
+// share the kernel, the real-axis mirroring and the colour mapping and
+// only differ in how they schedule the rows.
+class Renderer
+{
+public:
+    virtual ~Renderer() {}
+
+    virtual const char* name() const = 0;
+    virtual bool supports(const Formula& formula) const { (void)formula; return true; }
+
+    // The configurations the autotuner tries on this machine.
+    virtual QVector<RenderConfig> candidates() const = 0;
+
+    // Fills rows [beg, end) of out, a vp.width x vp.height buffer.
+    virtual void render_rows(const Formula& formula, const Viewport& vp, SmoothCount* out,
+                             int beg, int end, const RenderConfig& config) = 0;
+
+    void render(const Formula& formula, const Viewport& vp, SmoothCount* out, const RenderConfig& config)
+    {
+        MirrorPlan plan = { 0, vp.height, 0 };
+        if(formula.conjugate_symmetric)
+            plan = plan_mirror(vp);
+        render_rows(formula, vp, out, plan.first, plan.last, config);
+        mirror_rows(plan, vp.width, vp.height, out);
+    }
+};
+
+// Renders columns [left, right) of rows [beg, end) on the calling
+// thread, recording a TileStats when render_trace is set. Shared by the
+// CPU backends.
+void render_band(const Formula& formula, const Viewport& vp, SmoothCount* out,
+                 int beg, int end, int left, int right);
+
+// Backends compiled into this build, see cppmandel.pri.
+QStringList renderer_names();
+
+// Returns 0 if the backend is unknown or has no usable device.
+Renderer* create_renderer(const QString& name);
+
+#endif // RENDERER_H
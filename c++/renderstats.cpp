@@ -0,0 +1,109 @@
+#include "renderstats.h"
+#include <QThread>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+
+RenderTrace* render_trace = 0;
+
+RenderTrace::RenderTrace(const QString& path)
+    : m_path(path), m_frame(0)
+{
+    m_clock.start();
+}
+
+void RenderTrace::begin()
+{
+    QMutexLocker lock(&m_mutex);
+    m_tiles.clear();
+    m_clock.restart();
+    m_frame = 0;
+}
+
+void RenderTrace::end()
+{
+    m_frame = now();
+}
+
+void RenderTrace::record(TileStats& tile)
+{
+    QMutexLocker lock(&m_mutex);
+    void* thread = QThread::currentThread();
+    QHash<void*, int>::const_iterator it = m_workers.constFind(thread);
+    if(it == m_workers.constEnd())
+        it = m_workers.insert(thread, m_workers.size());
+    tile.worker = it.value();
+    m_tiles.append(tile);
+}
+
+bool RenderTrace::write() const
+{
+    QFile file(m_path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    out << "{\"traceEvents\":[\n";
+    for(int w = 0; w < m_workers.size(); ++w)
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << w
+            << ",\"args\":{\"name\":\"worker " << w << "\"}},\n";
+    for(int i = 0; i < m_tiles.size(); ++i)
+    {
+        const TileStats& t = m_tiles[i];
+        out << "{\"name\":\"tile " << t.beg << "-" << t.end << " x " << t.left << "-" << t.right
+            << "\",\"cat\":\"mandel\",\"ph\":\"X\""
+            << ",\"ts\":" << t.start / 1000.0 << ",\"dur\":" << (t.finish - t.start) / 1000.0
+            << ",\"pid\":1,\"tid\":" << t.worker
+            << ",\"args\":{\"iterations\":" << (qulonglong)t.iterations
+            << ",\"escaped\":" << t.escaped << ",\"interior\":" << t.interior << "}},\n";
+    }
+    out << "{\"name\":\"frame\",\"cat\":\"mandel\",\"ph\":\"X\",\"ts\":0,\"dur\":" << m_frame / 1000.0
+        << ",\"pid\":1,\"tid\":" << m_workers.size() << "}\n";
+    out << "]}\n";
+    return out.status() == QTextStream::Ok;
+}
+
+QString RenderTrace::summary() const
+{
+    QVector<qint64> busy(m_workers.size(), 0);
+    QVector<int> tiles(m_workers.size(), 0);
+    uint64_t iterations = 0;
+    qint64 escaped = 0, interior = 0;
+    const TileStats* slowest = 0;
+    for(int i = 0; i < m_tiles.size(); ++i)
+    {
+        const TileStats& t = m_tiles[i];
+        busy[t.worker] += t.finish - t.start;
+        ++tiles[t.worker];
+        iterations += t.iterations;
+        escaped += t.escaped;
+        interior += t.interior;
+        if(!slowest || t.finish - t.start > slowest->finish - slowest->start)
+            slowest = &t;
+    }
+
+    QString s;
+    QTextStream out(&s);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(2);
+    out << "frame " << m_frame / 1e6 << " ms, " << m_tiles.size() << " tiles, "
+        << (qulonglong)iterations << " iterations, "
+        << escaped << " escaped, " << interior << " interior\n";
+
+    qint64 total = 0, most = 0;
+    for(int w = 0; w < busy.size(); ++w)
+    {
+        total += busy[w];
+        most = std::max(most, busy[w]);
+        out << "worker " << w << ": " << tiles[w] << " tiles, busy " << busy[w] / 1e6
+            << " ms, idle " << (m_frame - busy[w]) / 1e6 << " ms\n";
+    }
+    if(!busy.isEmpty() && total > 0)
+        out << "imbalance (max / mean busy) " << (double)most * busy.size() / total << "\n";
+    if(slowest)
+        out << "slowest tile " << slowest->beg << "-" << slowest->end
+            << " x " << slowest->left << "-" << slowest->right << ": "
+            << (slowest->finish - slowest->start) / 1e6 << " ms, "
+            << (qulonglong)slowest->iterations << " iterations\n";
+    return s;
+}
@@ -0,0 +1,59 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <stdint.h>
+
+// What one render_band() call did over columns [left, right) of rows
+// [beg, end), whichever backend or batch made it. Timestamps are
+// nanoseconds since RenderTrace::begin().
+struct TileStats
+{
+    int beg;
+    int end;
+    int left;
+    int right;
+    uint64_t iterations;
+    int escaped;
+    int interior;
+    int worker;
+    qint64 start;
+    qint64 finish;
+};
+
+// Collects TileStats for one frame and exports them as a Chrome trace
+// (chrome://tracing, Perfetto) plus a plain text summary of per-thread
+// busy and idle time.
+//
+// Instrumentation is off unless render_trace points at a RenderTrace;
+// the render loops are instantiated once with and once without counters
+// so the untraced path pays a single branch per frame.
+class RenderTrace
+{
+    QString m_path;
+    QElapsedTimer m_clock;
+    qint64 m_frame;
+    QMutex m_mutex;
+    QHash<void*, int> m_workers;
+    QVector<TileStats> m_tiles;
+public:
+    RenderTrace(const QString& path);
+
+    void begin();
+    void end();
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    // Fills in the worker id and stores the tile, safe to call from any thread.
+    void record(TileStats& tile);
+
+    bool write() const;
+    QString summary() const;
+};
+
+extern RenderTrace* render_trace;
+
+#endif // RENDERSTATS_H
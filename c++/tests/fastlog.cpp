@@ -0,0 +1,52 @@
+// Checks the polynomial logarithm against libm: fast_log2() over the
+// whole range of normal exponents, and the smooth colouring phase it
+// feeds against the same phase computed with std::log.
+#define FAST_LOG
+#include "mandel.h"
+#include <stdio.h>
+
+const static double log2_bound = 1.1e-9;            // see fast_log2()
+const static double phase_bound = 1.0 / frac_scale; // one step of frac
+
+static double check_log2()
+{
+    double max_error = 0.0;
+    for(int e = -1020; e <= 1020; ++e)
+        for(int i = 0; i < 4096; ++i)
+        {
+            const double x = ldexp(1.0 + i / 4096.0, e);
+            max_error = std::max(max_error, fabs(fast_log2(x) - std::log(x) / ln2));
+        }
+    return max_error;
+}
+
+// From the escape radius up to the largest |z|^2 one step past it can
+// reach.
+static double check_phase(int& steps)
+{
+    double max_error = 0.0;
+    steps = 0;
+    for(int i = 0; i <= 1000000; ++i)
+    {
+        const double magz2 = escape2 * pow(escape2 + 1.0, i / 1000000.0);
+        const double fast = escape_phase<Mandelbrot>(magz2);
+        const double exact = std::log(std::log(magz2) / std::log(escape2)) / std::log(2.0);
+        max_error = std::max(max_error, fabs(fast - exact));
+        steps = std::max(steps, abs((int)quantize_phase(fast) - (int)quantize_phase(exact)));
+    }
+    return max_error;
+}
+
+int main()
+{
+    const double log2_error = check_log2();
+    printf("fast_log2: max error %.3g, bound %.3g\n", log2_error, log2_bound);
+
+    int steps;
+    const double phase_error = check_phase(steps);
+    printf("escape_phase: max error %.3g, bound %.3g, %d frac steps\n", phase_error, phase_bound, steps);
+
+    const bool ok = log2_error < log2_bound && phase_error < phase_bound && steps <= 1;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
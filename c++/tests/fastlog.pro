@@ -0,0 +1,12 @@
+# Accuracy of fast_log2() in mandel.h against libm. make check in any of
+# the frontends that include cppmandel.pri builds and runs it.
+
+TARGET = fastlog
+TEMPLATE = app
+
+CONFIG += console c++11 testcase
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += fastlog.cpp
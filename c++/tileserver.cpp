@@ -0,0 +1,248 @@
+#include "tileserver.h"
+#include "mandel.h"
+#include <QtGui>
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <vector>
+
+const static int tile_size = 256;
+const static int max_zoom = 29;
+
+// Latency histogram bucket bounds in milliseconds, the last bucket is +Inf.
+const static int latency_bounds[] = { 1, 4, 16, 64, 256, 1024, 4096 };
+const static int latency_buckets = sizeof(latency_bounds) / sizeof(latency_bounds[0]) + 1;
+
+inline quint64 tile_key(int z, int x, int y)
+{
+    return ((quint64)z << 58) | ((quint64)x << 29) | (quint64)y;
+}
+
+// ********************************************************************
+// Rendering
+class TileJob : public QRunnable
+{
+    QObject* m_server;
+    QAtomicInt* m_queued;
+    quint64 m_key;
+    int m_z, m_x, m_y;
+public:
+    TileJob(QObject* server, QAtomicInt* queued, int z, int x, int y)
+        : m_server(server), m_queued(queued), m_key(tile_key(z, x, y)), m_z(z), m_x(x), m_y(y)
+    {
+        // Owned by the server's Pending entry until tileReady(), so that
+        // the pointer there never refers to a freed or reused job.
+        setAutoDelete(false);
+    }
+    void run()
+    {
+        m_queued->deref();
+
+        // The 2^z x 2^z grid covers the same square as the interactive view.
+        const double step = 3.0 / ((double)tile_size * (1 << m_z));
+        const Viewport vp = { -2.0 + m_x * tile_size * step, -1.5 + m_y * tile_size * step,
+                              step, tile_size, tile_size };
+        std::vector<SmoothCount> counts(tile_size * tile_size);
+        render<Mandelbrot>(vp, &counts[0]);
+
+        // Tiles are normalized to a fixed range, like c++-task, so that
+        // neighbouring tiles agree on colours.
+        const double min_result = 1.0;
+        const double max_result = log(depth);
+        const double offset = smooth_offset<Mandelbrot>();
+        QImage image(tile_size, tile_size, QImage::Format_RGB32);
+        for(int y = 0; y < tile_size; ++y)
+        {
+            uint32_t* line = (uint32_t*)image.scanLine(y);
+            for(int x = 0; x < tile_size; ++x)
+                line[x] = map_to_argb(std::max(smooth_log(counts[y * tile_size + x], offset), min_result), min_result, max_result);
+        }
+
+        QByteArray png;
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "PNG");
+        QMetaObject::invokeMethod(m_server, "tileReady", Qt::QueuedConnection,
+                                  Q_ARG(quint64, m_key), Q_ARG(QByteArray, png));
+    }
+};
+
+// ********************************************************************
+// Server
+TileServer::TileServer(QObject* parent)
+    : QObject(parent),
+      m_requests(0), m_coalesced(0), m_rendered(0), m_errors(0),
+      m_latency_total(0), m_latency_max(0)
+{
+    std::fill(m_latency_buckets, m_latency_buckets + latency_buckets, 0);
+    m_clock.start();
+    connect(&m_tcp, SIGNAL(newConnection()), this, SLOT(tcpConnection()));
+    connect(&m_local, SIGNAL(newConnection()), this, SLOT(localConnection()));
+}
+
+TileServer::~TileServer()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+    for(QHash<quint64, Pending>::iterator it = m_pending.begin(); it != m_pending.end(); ++it)
+        delete it->job;
+}
+
+bool TileServer::listen(const QString& address)
+{
+    bool is_port = false;
+    const quint16 port = address.toUShort(&is_port);
+    if(is_port)
+        return m_tcp.listen(QHostAddress::LocalHost, port);
+    QLocalServer::removeServer(address);
+    return m_local.listen(address);
+}
+
+void TileServer::tcpConnection()
+{
+    while(QTcpSocket* socket = m_tcp.nextPendingConnection())
+        accept(socket);
+}
+
+void TileServer::localConnection()
+{
+    while(QLocalSocket* socket = m_local.nextPendingConnection())
+        accept(socket);
+}
+
+void TileServer::accept(QIODevice* socket)
+{
+    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+}
+
+void TileServer::readRequest()
+{
+    QIODevice* socket = qobject_cast<QIODevice*>(sender());
+    if(!socket || !socket->canReadLine())
+        return;
+    disconnect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+    request(socket, socket->readLine().trimmed());
+}
+
+void TileServer::request(QIODevice* socket, const QByteArray& line)
+{
+    const qint64 arrival = m_clock.nsecsElapsed();
+    const QList<QByteArray> words = line.split(' ');
+    if(words.size() < 2 || words[0] != "GET")
+    {
+        reply(socket, "400 Bad Request", "text/plain", "bad request\n");
+        return;
+    }
+
+    QByteArray path = words[1];
+    if(path == "/metrics")
+    {
+        reply(socket, "200 OK", "text/plain", metrics());
+        return;
+    }
+
+    const bool prefetch = path.endsWith("?prefetch");
+    if(prefetch)
+        path.chop(9);
+    const QList<QByteArray> parts = path.split('/');
+    bool ok[3] = { false, false, false };
+    int z = -1, x = -1, y = -1;
+    if(parts.size() == 4 && parts[0].isEmpty() && parts[3].endsWith(".png"))
+    {
+        z = parts[1].toInt(&ok[0]);
+        x = parts[2].toInt(&ok[1]);
+        y = parts[3].left(parts[3].size() - 4).toInt(&ok[2]);
+    }
+    if(!ok[0] || !ok[1] || !ok[2] || z < 0 || z > max_zoom ||
+       x < 0 || y < 0 || x >= (1 << z) || y >= (1 << z))
+    {
+        ++m_errors;
+        reply(socket, "404 Not Found", "text/plain", "no such tile\n");
+        return;
+    }
+
+    ++m_requests;
+    const int priority = (prefetch ? 0 : 100) - z;
+    const quint64 key = tile_key(z, x, y);
+    QHash<quint64, Pending>::iterator it = m_pending.find(key);
+    if(it != m_pending.end())
+    {
+        ++m_coalesced;
+        // A tile that was only prefetched becomes urgent once someone looks at it.
+        if(priority > it->priority && m_pool.tryTake(it->job))
+        {
+            it->priority = priority;
+            m_pool.start(it->job, priority);
+        }
+    }
+    else
+    {
+        it = m_pending.insert(key, Pending());
+        it->job = new TileJob(this, &m_queued, z, x, y);
+        it->priority = priority;
+        m_queued.ref();
+        m_pool.start(it->job, priority);
+    }
+    it->clients.append(socket);
+    it->arrivals.append(arrival);
+}
+
+void TileServer::tileReady(quint64 key, const QByteArray& png)
+{
+    const Pending pending = m_pending.take(key);
+    delete pending.job;
+    ++m_rendered;
+    const qint64 now = m_clock.nsecsElapsed();
+    for(int i = 0; i < pending.clients.size(); ++i)
+    {
+        if(pending.clients[i])
+            reply(pending.clients[i], "200 OK", "image/png", png);
+        record_latency(now - pending.arrivals[i]);
+    }
+}
+
+void TileServer::reply(QIODevice* socket, const char* status, const char* type, const QByteArray& body)
+{
+    socket->write(QByteArray("HTTP/1.0 ") + status + "\r\n" +
+                  "Content-Type: " + type + "\r\n" +
+                  "Content-Length: " + QByteArray::number(body.size()) + "\r\n" +
+                  "Connection: close\r\n\r\n");
+    socket->write(body);
+    if(QTcpSocket* tcp = qobject_cast<QTcpSocket*>(socket))
+        tcp->disconnectFromHost();
+    else if(QLocalSocket* local = qobject_cast<QLocalSocket*>(socket))
+        local->disconnectFromServer();
+}
+
+void TileServer::record_latency(qint64 nsecs)
+{
+    m_latency_total += nsecs;
+    m_latency_max = std::max(m_latency_max, nsecs);
+    int bucket = 0;
+    while(bucket < latency_buckets - 1 && nsecs > latency_bounds[bucket] * qint64(1000000))
+        ++bucket;
+    ++m_latency_buckets[bucket];
+}
+
+QByteArray TileServer::metrics() const
+{
+    QByteArray out;
+    out += "tile_queue_depth " + QByteArray::number(m_queued.load()) + "\n";
+    out += "tile_inflight " + QByteArray::number(m_pending.size()) + "\n";
+    out += "tile_requests_total " + QByteArray::number(m_requests) + "\n";
+    out += "tile_coalesced_total " + QByteArray::number(m_coalesced) + "\n";
+    out += "tile_rendered_total " + QByteArray::number(m_rendered) + "\n";
+    out += "tile_errors_total " + QByteArray::number(m_errors) + "\n";
+
+    quint64 count = 0;
+    for(int i = 0; i < latency_buckets; ++i)
+    {
+        count += m_latency_buckets[i];
+        const QByteArray le = i < latency_buckets - 1 ? QByteArray::number(latency_bounds[i] / 1000.0) : "+Inf";
+        out += "tile_latency_seconds_bucket{le=\"" + le + "\"} " + QByteArray::number(count) + "\n";
+    }
+    out += "tile_latency_seconds_sum " + QByteArray::number(m_latency_total / 1e9) + "\n";
+    out += "tile_latency_seconds_count " + QByteArray::number(count) + "\n";
+    out += "tile_latency_seconds_max " + QByteArray::number(m_latency_max / 1e9) + "\n";
+    return out;
+}
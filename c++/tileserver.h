@@ -0,0 +1,70 @@
+#ifndef TILESERVER_H
+#define TILESERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QTcpServer>
+#include <QLocalServer>
+
+class TileJob;
+
+// Serves 256x256 PNG tiles over a minimal HTTP/1.0 protocol:
+//
+//   GET /<z>/<x>/<y>.png[?prefetch]   tile x, y of the 2^z x 2^z grid
+//   GET /metrics                      queue depth, latency and counters
+//
+// so that any local client (curl --unix-socket works too) can talk to it.
+// Requests for a tile that is already queued or rendering wait for that
+// render instead of starting another one. Visible tiles are scheduled
+// before prefetches and low zoom levels before high ones.
+class TileServer : public QObject
+{
+    Q_OBJECT
+
+    struct Pending
+    {
+        TileJob* job;
+        int priority;
+        QList<QPointer<QIODevice> > clients;
+        QList<qint64> arrivals;
+    };
+
+    QTcpServer m_tcp;
+    QLocalServer m_local;
+    QThreadPool m_pool;
+    QHash<quint64, Pending> m_pending;
+    QElapsedTimer m_clock;
+
+    // metrics
+    QAtomicInt m_queued;
+    quint64 m_requests;
+    quint64 m_coalesced;
+    quint64 m_rendered;
+    quint64 m_errors;
+    qint64 m_latency_total;
+    qint64 m_latency_max;
+    quint64 m_latency_buckets[8];
+
+    void accept(QIODevice* socket);
+    void request(QIODevice* socket, const QByteArray& line);
+    void reply(QIODevice* socket, const char* status, const char* type, const QByteArray& body);
+    void record_latency(qint64 nsecs);
+    QByteArray metrics() const;
+private slots:
+    void tcpConnection();
+    void localConnection();
+    void readRequest();
+    void tileReady(quint64 key, const QByteArray& png);
+public:
+    TileServer(QObject* parent = 0);
+    ~TileServer();
+
+    // A port number listens on 127.0.0.1, anything else is a socket path.
+    bool listen(const QString& address);
+};
+
+#endif // TILESERVER_H
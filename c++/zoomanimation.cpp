@@ -0,0 +1,132 @@
+#include "zoomanimation.h"
+#include "parallel.h"
+#include <QtGui>
+#include <QtConcurrent>
+#include <vector>
+
+// ********************************************************************
+// Exponential map
+//
+// Column j of the strip is the angle 2*pi*j/columns, row i is the radius
+// exp(log_inner + i*step). Rows and columns share the same step so that
+// a strip sample is square at every radius, and the column count is
+// chosen so the outermost pixel of a frame is sampled about once.
+class ExpMap
+{
+    std::complex<double> m_center;
+    double m_log_inner;
+    double m_step;
+    int m_columns;
+    int m_rows;
+    std::vector<float> m_strip;
+
+    void render_rows(int beg, int end)
+    {
+        for(int i = beg; i < end; ++i)
+        {
+            float* row = &m_strip[(size_t)i * m_columns];
+            const double radius = exp(m_log_inner + i * m_step);
+            for(int j = 0; j < m_columns; ++j)
+                row[j] = (float)mandel(m_center + std::polar(radius, j * m_step));
+        }
+    }
+public:
+    double min_result;
+    double max_result;
+
+    ExpMap(const std::complex<double>& center, double inner, double outer, int columns)
+        : m_center(center),
+          m_log_inner(log(inner)),
+          m_step(2.0 * M_PI / columns),
+          m_columns(columns),
+          m_rows((int)ceil((log(outer) - log(inner)) / m_step) + 2),
+          m_strip((size_t)m_rows * columns)
+    {
+        parallel_range(m_rows, [this](int beg, int end) { render_rows(beg, end); });
+        min_result = *(std::min_element(m_strip.begin(), m_strip.end()));
+        max_result = *(std::max_element(m_strip.begin(), m_strip.end()));
+    }
+
+    size_t samples() const { return m_strip.size(); }
+
+    // Bilinear lookup of the smooth iteration count at offset d from the center.
+    double sample(const std::complex<double>& d) const
+    {
+        double u = (log(std::max(std::abs(d), 1e-300)) - m_log_inner) / m_step;
+        double v = std::arg(d) / m_step;
+        if(v < 0)
+            v += m_columns;
+        u = std::min(std::max(u, 0.0), m_rows - 1.001);
+
+        const int i = (int)u;
+        const int j = (int)v % m_columns;
+        const int j1 = (j + 1) % m_columns;
+        const double fu = u - i;
+        const double fv = v - floor(v);
+        const float* r0 = &m_strip[(size_t)i * m_columns];
+        const float* r1 = r0 + m_columns;
+        const double a = r0[j] + (r0[j1] - r0[j]) * fv;
+        const double b = r1[j] + (r1[j1] - r1[j]) * fv;
+        return a + (b - a) * fu;
+    }
+};
+
+// ********************************************************************
+// Frames
+bool render_zoom(const ZoomSpec& spec, const QString& dir)
+{
+    if(spec.frames < 1 || spec.width < 1 || spec.height < 1 ||
+       spec.start_radius <= 0 || spec.end_radius <= 0)
+        return false;
+    if(!QDir().mkpath(dir))
+        return false;
+
+    const int w = spec.width;
+    const int h = spec.height;
+    const double half_diagonal = 0.5 * sqrt((double)w * w + (double)h * h);
+    const double zoom = spec.frames > 1 ? log(spec.end_radius / spec.start_radius) / (spec.frames - 1) : 0.0;
+    const double min_pixel = 2.0 * std::min(spec.start_radius, spec.end_radius) / h;
+    const double max_pixel = 2.0 * std::max(spec.start_radius, spec.end_radius) / h;
+    const std::complex<double> center(spec.center_x, spec.center_y);
+
+    QElapsedTimer time;
+    time.start();
+    const ExpMap strip(center,
+                       0.5 * min_pixel,
+                       max_pixel * half_diagonal,
+                       (int)ceil(2.0 * M_PI * half_diagonal));
+    qDebug("exponential map: %llu samples in %lld milliseconds",
+           (unsigned long long)strip.samples(), (long long)time.elapsed());
+
+    // Frame f is resampled while frame f - 1 is still being written out.
+    QImage frames[2] = { QImage(w, h, QImage::Format_RGB32), QImage(w, h, QImage::Format_RGB32) };
+    QFuture<bool> written;
+    bool ok = true;
+    time.restart();
+    for(int f = 0; f < spec.frames && ok; ++f)
+    {
+        QImage& image = frames[f & 1];
+        uchar* bits = image.bits();
+        const int stride = image.bytesPerLine();
+        const double pixel = 2.0 * spec.start_radius * exp(zoom * f) / h;
+        parallel_range(h, [&](int beg, int end) {
+            for(int y = beg; y < end; ++y)
+            {
+                uint32_t* line = (uint32_t*)(bits + y * stride);
+                for(int x = 0; x < w; ++x)
+                {
+                    const std::complex<double> d((x - 0.5 * w) * pixel, (y - 0.5 * h) * pixel);
+                    line[x] = map_to_argb(strip.sample(d), strip.min_result, strip.max_result);
+                }
+            }
+        });
+
+        if(f > 0)
+            ok = written.result();
+        const QString path = QDir(dir).filePath(QString("frame_%1.png").arg(f, 5, 10, QChar('0')));
+        written = QtConcurrent::run([image, path]() { return image.save(path); });
+    }
+    ok = written.result() && ok;
+    qDebug("%d frames in %lld milliseconds", spec.frames, (long long)time.elapsed());
+    return ok;
+}
@@ -0,0 +1,23 @@
+#ifndef ZOOMANIMATION_H
+#define ZOOMANIMATION_H
+
+#include <QString>
+
+// A zoom towards (center_x, center_y), from a view of half height
+// start_radius down to end_radius, in frames of width x height.
+struct ZoomSpec
+{
+    double center_x;
+    double center_y;
+    double start_radius;
+    double end_radius;
+    int frames;
+    int width;
+    int height;
+};
+
+// Renders the whole zoom path once as an exponential map (log-polar strip)
+// and resamples every frame from it, writing frame_NNNNN.png into dir.
+bool render_zoom(const ZoomSpec& spec, const QString& dir);
+
+#endif // ZOOMANIMATION_H
@@ -25,7 +25,5 @@ win32{
   }
 }
 
-SOURCES += main.cpp\
-        mandelbrotview.cpp
-
-HEADERS  += mandelbrotview.h
+CONFIG += opencl
+include(../c++/cppmandel.pri)